@@ -0,0 +1,98 @@
+// Benchmark kernel khoảng cách: 1k đạn x 1k người chơi (1M cặp ứng viên),
+// so sánh vòng lặp cũ (int + std::sqrt) với các bản scalar / SSE2 / AVX2.
+#include "src/core/distanceKernel.h"
+#include <benchmark/benchmark.h>
+#include <cmath>
+#include <random>
+#include <vector>
+
+namespace
+{
+    constexpr int kCount = 1000;
+    constexpr int kRadius = 15;
+
+    struct Positions
+    {
+        std::vector<int> bulletX, bulletY;
+        std::vector<int> playerX, playerY;
+
+        Positions()
+        {
+            std::mt19937 rng(42);
+            std::uniform_int_distribution<int> coord(0, 2000);
+            for (int i = 0; i < kCount; ++i)
+            {
+                bulletX.push_back(coord(rng));
+                bulletY.push_back(coord(rng));
+                playerX.push_back(coord(rng));
+                playerY.push_back(coord(rng));
+            }
+        }
+    };
+
+    const Positions &positions()
+    {
+        static const Positions p;
+        return p;
+    }
+
+    // Đúng phép kiểm tra của checkBulletCollisions trước khi có kernel
+    void BM_SqrtBaseline(benchmark::State &state)
+    {
+        const Positions &p = positions();
+        for (auto _ : state)
+        {
+            uint32_t hits = 0;
+            for (int b = 0; b < kCount; ++b)
+            {
+                for (int i = 0; i < kCount; ++i)
+                {
+                    int dx = p.playerX[i] - p.bulletX[b];
+                    int dy = p.playerY[i] - p.bulletY[b];
+                    int dist = static_cast<int>(std::sqrt(dx * dx + dy * dy));
+                    if (dist < kRadius)
+                        ++hits;
+                }
+            }
+            benchmark::DoNotOptimize(hits);
+        }
+        state.SetItemsProcessed(state.iterations() * kCount * kCount);
+    }
+
+    void runKernel(benchmark::State &state, WithinRadiusFn fn)
+    {
+        if (!fn)
+        {
+            state.SkipWithError("CPU không hỗ trợ");
+            return;
+        }
+        const Positions &p = positions();
+        std::vector<uint32_t> out(kCount);
+        for (auto _ : state)
+        {
+            uint32_t hits = 0;
+            for (int b = 0; b < kCount; ++b)
+                hits += fn(p.bulletX[b], p.bulletY[b], p.playerX.data(), p.playerY.data(), kCount, kRadius, out.data());
+            benchmark::DoNotOptimize(hits);
+        }
+        state.SetItemsProcessed(state.iterations() * kCount * kCount);
+    }
+
+    void BM_KernelScalar(benchmark::State &state) { runKernel(state, withinRadiusScalarFn()); }
+    void BM_KernelSse2(benchmark::State &state) { runKernel(state, withinRadiusSse2Fn()); }
+    void BM_KernelAvx2(benchmark::State &state) { runKernel(state, withinRadiusAvx2Fn()); }
+
+    void BM_KernelDispatch(benchmark::State &state)
+    {
+        state.SetLabel(withinRadiusBackend());
+        runKernel(state, withinRadius);
+    }
+}
+
+BENCHMARK(BM_SqrtBaseline);
+BENCHMARK(BM_KernelScalar);
+BENCHMARK(BM_KernelSse2);
+BENCHMARK(BM_KernelAvx2);
+BENCHMARK(BM_KernelDispatch);
+
+BENCHMARK_MAIN();
@@ -0,0 +1,143 @@
+// Benchmark một tick Gameplay đầy đủ (lệnh đầu vào, mô phỏng, dựng + mã hoá snapshot)
+// trên transport giả, không cần msquic. Tham số: số người chơi, số đạn duy trì,
+// số vật phẩm duy trì và kiểu di chuyển. Báo ns/tick từng pha và số byte mỗi snapshot.
+// Việc tạo lệnh (JSON) nằm ngoài vùng đo vì chạy trên luồng mạng.
+#include "src/core/gameplay.h"
+#include <benchmark/benchmark.h>
+#include <random>
+#include <string>
+
+namespace
+{
+    enum Pattern : int64_t
+    {
+        Static = 0,     // đứng yên: chỉ còn chi phí va chạm và snapshot delta rỗng
+        RandomWalk = 1, // đi ngẫu nhiên trên toàn bản đồ 2000x2000
+        Clustered = 2,  // dồn vào một vùng 300x300: trường hợp xấu cho lưới và tầm nhìn
+    };
+
+    // Transport giả: chỉ đếm số tin và số byte
+    class CountingTransport : public Transport
+    {
+    public:
+        bool sendMessage(ConnectionId, std::string &&msg, TrafficClass) override
+        {
+            messages++;
+            bytes += msg.size();
+            return true;
+        }
+
+        size_t broadcast(const std::vector<ConnectionId> &conns, std::string msg, TrafficClass) override
+        {
+            messages += conns.size();
+            bytes += msg.size() * conns.size();
+            return conns.size();
+        }
+
+        void disconnect(ConnectionId) override {}
+
+        uint64_t messages = 0;
+        uint64_t bytes = 0;
+    };
+
+    std::string moveMessage(int x, int y)
+    {
+        return "{\"action\":\"move\",\"x\":" + std::to_string(x) + ",\"y\":" + std::to_string(y) + "}";
+    }
+
+    void BM_GameplayTick(benchmark::State &state)
+    {
+        const int players = static_cast<int>(state.range(0));
+        const uint32_t bullets = static_cast<uint32_t>(state.range(1));
+        const uint32_t items = static_cast<uint32_t>(state.range(2));
+        const auto pattern = static_cast<Pattern>(state.range(3));
+
+        GameplayConfig config;
+        config.logEvents = false;
+        config.shotCooldownMs = 0; // bắn bù cho đủ số đạn mỗi tick, không tính cooldown
+        config.inputQueueCapacity = players * 4 + 64;
+        boost::asio::io_context io;
+        CountingTransport transport;
+        Gameplay game(transport, io, config);
+
+        std::mt19937 rng(42);
+        const int span = pattern == Clustered ? 300 : 2000;
+        const int origin = pattern == Clustered ? 850 : 0;
+        std::uniform_int_distribution<int> coord(0, span - 1);
+        std::uniform_int_distribution<int> step(-10, 10);
+        std::uniform_real_distribution<double> dir(-1.0, 1.0);
+        std::vector<int> px(players), py(players);
+
+        for (int i = 0; i < players; ++i)
+        {
+            game.handleMessage(i + 1, "{\"action\":\"join\",\"player\":\"bot" + std::to_string(i) + "\",\"encodings\":[\"bin1\"]}");
+            px[i] = origin + coord(rng);
+            py[i] = origin + coord(rng);
+            game.handleMessage(i + 1, moveMessage(px[i], py[i]));
+        }
+        game.runTick();
+        const std::string shootPrefix = "{\"action\":\"shoot\",\"x\":";
+
+        // Mỗi tick: client ack snapshot trước, người chơi di chuyển, bắn bù cho đủ số đạn
+        auto prepareInputs = [&]()
+        {
+            const std::string ack = "{\"action\":\"ack\",\"tick\":" + std::to_string(game.world().tick()) + "}";
+            for (int i = 0; i < players; ++i)
+            {
+                game.handleMessage(i + 1, ack);
+                if (pattern != Static)
+                {
+                    px[i] = std::clamp(px[i] + step(rng), origin, origin + span - 1);
+                    py[i] = std::clamp(py[i] + step(rng), origin, origin + span - 1);
+                    game.handleMessage(i + 1, moveMessage(px[i], py[i]));
+                }
+            }
+            for (uint32_t b = static_cast<uint32_t>(game.world().bullets().size()); b < bullets && players > 0; ++b)
+            {
+                int shooter = static_cast<int>(rng() % players);
+                game.handleMessage(shooter + 1, shootPrefix + std::to_string(px[shooter]) + ",\"y\":" + std::to_string(py[shooter]) +
+                                                    ",\"dx\":" + std::to_string(dir(rng)) + ",\"dy\":" + std::to_string(dir(rng)) + "}");
+            }
+            while (game.world().items().size() < items)
+                game.world().spawnItem();
+        };
+
+        const uint64_t bytesBefore = transport.bytes;
+        const uint64_t messagesBefore = transport.messages;
+        const uint64_t ticksBefore = game.tickStats().ticks;
+
+        for (auto _ : state)
+        {
+            state.PauseTiming();
+            prepareInputs();
+            state.ResumeTiming();
+            game.runTick();
+        }
+
+        const TickStats stats = game.tickStats();
+        const uint64_t messages = transport.messages - messagesBefore;
+        const uint64_t ticks = stats.ticks - ticksBefore;
+        for (size_t p = 0; p < stats.phases.size(); ++p)
+        {
+            const LatencyHistogram &h = stats.phases[p];
+            state.counters[std::string(tickPhaseName(static_cast<TickPhase>(p))) + "_ns"] = static_cast<double>(h.mean());
+        }
+        state.counters["snapshot_bytes"] = messages ? static_cast<double>(transport.bytes - bytesBefore) / messages : 0.0;
+        state.counters["bytes_per_tick"] = ticks ? static_cast<double>(transport.bytes - bytesBefore) / ticks : 0.0;
+    }
+
+    void TickArgs(benchmark::internal::Benchmark *b)
+    {
+        b->ArgNames({"players", "bullets", "items", "pattern"});
+        for (int64_t pattern : {Static, RandomWalk, Clustered})
+        {
+            b->Args({50, 50, 20, pattern});
+            b->Args({200, 200, 50, pattern});
+            b->Args({1000, 1000, 200, pattern});
+        }
+    }
+}
+
+BENCHMARK(BM_GameplayTick)->Apply(TickArgs)->Unit(benchmark::kMicrosecond);
+
+BENCHMARK_MAIN();
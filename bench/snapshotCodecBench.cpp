@@ -0,0 +1,174 @@
+// Benchmark bộ mã hoá snapshot: đường JSON gốc (mỗi client dựng cây nlohmann từ từng
+// thực thể rồi dump() + "\n", như broadcastGameState trước khi có SnapshotMessage), bộ mã
+// hoá JSON hiện tại và khung nhị phân bin1. Báo số byte mỗi snapshot và ns cho mỗi thực
+// thể, với snapshot đầy đủ và delta.
+#include "src/core/snapshotCodec.h"
+#include <benchmark/benchmark.h>
+#include <nlohmann/json.hpp>
+#include <chrono>
+#include <random>
+#include <string>
+
+using json = nlohmann::json;
+
+namespace
+{
+    enum class Codec
+    {
+        LegacyJson,
+        Json,
+        Binary,
+    };
+
+    // Đường cũ: các hàm playerJson/itemJson/bulletJson trả về object riêng cho từng
+    // thực thể, bảng xếp hạng dựng một lần mỗi tick rồi chép vào từng snapshot
+    const std::string &legacyName(const PlayerStore &players, EntityId id)
+    {
+        static const std::string empty;
+        uint32_t i = players.indexOf(id);
+        return i != kNoIndex ? players.name[i] : empty;
+    }
+
+    json legacyPlayerJson(const PlayerStore &players, const PlayerState &s, bool created)
+    {
+        json j = {{"id", s.id}, {"x", s.x}, {"y", s.y}, {"score", s.score}};
+        if (created)
+            j["name"] = legacyName(players, s.id);
+        return j;
+    }
+
+    json legacyItemJson(const ItemState &s)
+    {
+        return {{"id", s.id}, {"x", s.x}, {"y", s.y}};
+    }
+
+    json legacyBulletJson(const PlayerStore &players, const BulletState &s, bool created)
+    {
+        json j = {{"id", s.id}, {"x", s.x}, {"y", s.y}};
+        if (created)
+        {
+            j["dx"] = s.dx;
+            j["dy"] = s.dy;
+            j["shooter"] = legacyName(players, s.shooter);
+        }
+        return j;
+    }
+
+    json legacyLeaderboard(const SnapshotMessage &msg, const PlayerStore &players)
+    {
+        json leaderboard = json::array();
+        for (const auto &e : msg.leaderboard)
+            leaderboard.push_back({{"name", legacyName(players, e.id)}, {"score", e.score}});
+        return leaderboard;
+    }
+
+    std::string encodeLegacyJson(const SnapshotMessage &msg, const PlayerStore &players, const json &leaderboard)
+    {
+        json state_json = json::object();
+        state_json["tick"] = msg.tick;
+        state_json["players"] = json::array();
+        state_json["items"] = json::array();
+        state_json["bullets"] = json::array();
+        for (const auto &e : msg.players)
+            state_json["players"].push_back(legacyPlayerJson(players, e.state, e.created));
+        for (const auto &it : msg.items)
+            state_json["items"].push_back(legacyItemJson(it));
+        for (const auto &e : msg.bullets)
+            state_json["bullets"].push_back(legacyBulletJson(players, e.state, e.created));
+        if (msg.baseline != 0)
+        {
+            state_json["baseline"] = msg.baseline;
+            json removed = {{"players", json::array()}, {"items", json::array()}, {"bullets", json::array()}};
+            for (EntityId id : msg.removedPlayers)
+                removed["players"].push_back(id);
+            for (EntityId id : msg.removedItems)
+                removed["items"].push_back(id);
+            for (EntityId id : msg.removedBullets)
+                removed["bullets"].push_back(id);
+            state_json["removed"] = std::move(removed);
+        }
+        state_json["leaderboard"] = leaderboard;
+        state_json["playerCount"] = msg.playerCount;
+        return state_json.dump() + "\n";
+    }
+
+    struct Fixture
+    {
+        PlayerStore players;
+        SnapshotMessage full;
+        SnapshotMessage delta;
+
+        explicit Fixture(int count)
+        {
+            std::mt19937 rng(7);
+            std::uniform_int_distribution<int> coord(0, 2000);
+            std::uniform_real_distribution<double> dir(-1.0, 1.0);
+
+            for (int i = 0; i < count; ++i)
+                players.create(i, "Player" + std::to_string(i), coord(rng), coord(rng));
+
+            full.tick = 1000;
+            full.playerCount = count;
+            for (uint32_t i = 0; i < players.size(); ++i)
+            {
+                PlayerState st{players.id[i], players.x[i], players.y[i], static_cast<int>(rng() % 50)};
+                full.players.push_back({st, true});
+                full.items.push_back({i + 1, coord(rng), coord(rng)});
+                full.bullets.push_back({{i + 1, coord(rng), coord(rng), dir(rng), dir(rng), players.id[i]}, true});
+            }
+            for (uint32_t i = 0; i < 10 && i < players.size(); ++i)
+                full.leaderboard.push_back({players.id[i], 50 - static_cast<int>(i)});
+
+            // Delta điển hình: 1/4 người chơi di chuyển, đạn bay, vật phẩm đứng yên
+            delta.tick = 1001;
+            delta.baseline = 1000;
+            delta.playerCount = count;
+            for (size_t i = 0; i < full.players.size(); i += 4)
+                delta.players.push_back({full.players[i].state, false});
+            for (const auto &b : full.bullets)
+                delta.bullets.push_back({b.state, false});
+            delta.removedItems.push_back(1);
+            delta.leaderboard = full.leaderboard;
+        }
+
+        uint64_t entities(const SnapshotMessage &m) const
+        {
+            return m.players.size() + m.items.size() + m.bullets.size();
+        }
+    };
+
+    template <Codec C, bool Delta>
+    void BM_Encode(benchmark::State &state)
+    {
+        Fixture f(static_cast<int>(state.range(0)));
+        const SnapshotMessage &msg = Delta ? f.delta : f.full;
+        const json leaderboard = legacyLeaderboard(msg, f.players);
+        std::string out;
+        const auto start = std::chrono::steady_clock::now();
+        for (auto _ : state)
+        {
+            if constexpr (C == Codec::LegacyJson)
+                out = encodeLegacyJson(msg, f.players, leaderboard);
+            else if constexpr (C == Codec::Json)
+                encodeSnapshotJson(msg, f.players, out);
+            else
+                encodeSnapshotBinary(msg, f.players, out);
+            benchmark::DoNotOptimize(out.data());
+        }
+        const double elapsedNs = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+        const uint64_t entities = f.entities(msg);
+        state.SetItemsProcessed(static_cast<int64_t>(state.iterations() * entities));
+        state.counters["bytes"] = static_cast<double>(out.size());
+        state.counters["bytes_per_entity"] = static_cast<double>(out.size()) / entities;
+        state.counters["ns_per_entity"] = elapsedNs / (static_cast<double>(state.iterations()) * entities);
+    }
+}
+
+BENCHMARK_TEMPLATE(BM_Encode, Codec::LegacyJson, false)->Name("LegacyJson/Full")->Arg(50)->Arg(500);
+BENCHMARK_TEMPLATE(BM_Encode, Codec::Json, false)->Name("Json/Full")->Arg(50)->Arg(500);
+BENCHMARK_TEMPLATE(BM_Encode, Codec::Binary, false)->Name("Binary/Full")->Arg(50)->Arg(500);
+BENCHMARK_TEMPLATE(BM_Encode, Codec::LegacyJson, true)->Name("LegacyJson/Delta")->Arg(50)->Arg(500);
+BENCHMARK_TEMPLATE(BM_Encode, Codec::Json, true)->Name("Json/Delta")->Arg(50)->Arg(500);
+BENCHMARK_TEMPLATE(BM_Encode, Codec::Binary, true)->Name("Binary/Delta")->Arg(50)->Arg(500);
+
+BENCHMARK_MAIN();
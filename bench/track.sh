@@ -0,0 +1,55 @@
+#!/usr/bin/env bash
+# Chạy một benchmark, lưu kết quả JSON theo commit vào bench/results/ và so sánh
+# với lần chạy gần nhất trước đó.
+#
+#   bench/track.sh [tên benchmark, mặc định gameplay_bench] [tham số thêm cho benchmark]
+#
+# BUILD_DIR chỉ thư mục build (mặc định build).
+set -euo pipefail
+
+BENCH=${1:-gameplay_bench}
+shift || true
+BUILD_DIR=${BUILD_DIR:-build}
+OUT_DIR="$(cd "$(dirname "$0")" && pwd)/results"
+mkdir -p "$OUT_DIR"
+
+COMMIT=$(git rev-parse --short HEAD)
+if [ -n "$(git status --porcelain --untracked-files=no)" ]; then
+    COMMIT="$COMMIT-dirty"
+fi
+OUT="$OUT_DIR/$BENCH-$COMMIT.json"
+PREV=$(ls -t "$OUT_DIR"/"$BENCH"-*.json 2>/dev/null | grep -vF "$OUT" | head -n 1 || true)
+
+"$BUILD_DIR/$BENCH" \
+    --benchmark_repetitions=3 \
+    --benchmark_report_aggregates_only=true \
+    --benchmark_out="$OUT" \
+    --benchmark_out_format=json \
+    "$@"
+
+echo "Saved $OUT"
+if [ -z "$PREV" ]; then
+    exit 0
+fi
+
+echo "Compared with $PREV (median):"
+python3 - "$PREV" "$OUT" <<'PY'
+import json, sys
+
+def load(path):
+    with open(path) as f:
+        data = json.load(f)
+    return {b["run_name"]: b for b in data["benchmarks"] if b.get("aggregate_name") == "median"}
+
+old, new = load(sys.argv[1]), load(sys.argv[2])
+for name, b in new.items():
+    a = old.get(name)
+    if not a:
+        print(f"  {name}: new")
+        continue
+    change = (b["real_time"] - a["real_time"]) / a["real_time"] * 100 if a["real_time"] else 0.0
+    line = f"  {name}: {a['real_time']:.1f} -> {b['real_time']:.1f} {b['time_unit']} ({change:+.1f}%)"
+    if "snapshot_bytes" in b and "snapshot_bytes" in a:
+        line += f", snapshot {a['snapshot_bytes']:.0f} -> {b['snapshot_bytes']:.0f} B"
+    print(line)
+PY
@@ -1,5 +1,7 @@
 #include "AsioService.h"
 #include <iostream>
+#include <pthread.h>
+#include <sched.h>
 
 AsioService::AsioService()
     : ioContext_(std::make_unique<boost::asio::io_context>())
@@ -18,10 +20,19 @@ boost::asio::io_context &AsioService::getContext()
     return *ioContext_;
 }
 
-void AsioService::start()
+void AsioService::start(int cpu)
 {
     asioThread_ = std::thread([this]()
                               { ioContext_->run(); });
+
+    if (cpu >= 0)
+    {
+        cpu_set_t set;
+        CPU_ZERO(&set);
+        CPU_SET(cpu, &set);
+        if (pthread_setaffinity_np(asioThread_.native_handle(), sizeof(set), &set) != 0)
+            std::cerr << "[AsioService] Failed to pin thread to cpu " << cpu << std::endl;
+    }
 }
 
 void AsioService::stop()
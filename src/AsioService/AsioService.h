@@ -12,8 +12,8 @@ public:
     // Lấy reference đến io_context
     boost::asio::io_context &getContext();
 
-    // Bắt đầu loop trong thread riêng
-    void start();
+    // Bắt đầu loop trong thread riêng; cpu >= 0 thì ghim thread vào core đó
+    void start(int cpu = -1);
 
     // Dừng loop và join thread
     void stop();
@@ -0,0 +1,53 @@
+#include "IoContextPool.h"
+#include <algorithm>
+#include <iostream>
+#include <thread>
+
+IoContextPool::IoContextPool(int threads)
+{
+    const unsigned cores = std::max(1u, std::thread::hardware_concurrency());
+    const size_t count = threads > 0 ? static_cast<size_t>(threads) : cores;
+    for (size_t i = 0; i < count; ++i)
+    {
+        services_.push_back(std::make_unique<AsioService>());
+        const uint16_t cpu = static_cast<uint16_t>(i % cores);
+        if (std::find(cpus_.begin(), cpus_.end(), cpu) == cpus_.end())
+            cpus_.push_back(cpu);
+    }
+}
+
+IoContextPool::~IoContextPool()
+{
+    stop();
+}
+
+void IoContextPool::start()
+{
+    if (running_)
+        return;
+    running_ = true;
+
+    const unsigned cores = std::max(1u, std::thread::hardware_concurrency());
+    for (size_t i = 0; i < services_.size(); ++i)
+        services_[i]->start(static_cast<int>(i % cores));
+    std::cout << "[IoContextPool] Started " << services_.size() << " io threads\n";
+}
+
+void IoContextPool::stop()
+{
+    if (!running_)
+        return;
+    running_ = false;
+    for (auto &service : services_)
+        service->stop();
+}
+
+size_t IoContextPool::indexForKey(uint64_t key) const
+{
+    // splitmix64: id tăng dần vẫn rải đều, không dính theo chu kỳ với cách chia phòng
+    key += 0x9E3779B97F4A7C15ull;
+    key = (key ^ (key >> 30)) * 0xBF58476D1CE4E5B9ull;
+    key = (key ^ (key >> 27)) * 0x94D049BB133111EBull;
+    key ^= key >> 31;
+    return static_cast<size_t>(key % services_.size());
+}
@@ -0,0 +1,37 @@
+#pragma once
+#include <boost/asio.hpp>
+#include <cstdint>
+#include <memory>
+#include <vector>
+#include "AsioService.h"
+
+// Nhóm N io_context, mỗi cái một thread ghim vào một core. Mỗi kết nối được gắn cố định
+// vào một io_context theo hash của khoá (ConnectionId), nên các handler của cùng một kết
+// nối vẫn chạy tuần tự đúng thứ tự post, còn các kết nối khác nhau chạy song song.
+class IoContextPool
+{
+public:
+    // threads <= 0 nghĩa là theo số core của máy
+    explicit IoContextPool(int threads = 0);
+    ~IoContextPool();
+
+    // Chạy các thread; thread i ghim vào core i % số core
+    void start();
+    void stop();
+
+    bool running() const { return running_; }
+    size_t size() const { return services_.size(); }
+    boost::asio::io_context &get(size_t index) { return services_[index]->getContext(); }
+
+    // io_context của một khoá: cùng khoá luôn ra cùng io_context
+    boost::asio::io_context &forKey(uint64_t key) { return get(indexForKey(key)); }
+    size_t indexForKey(uint64_t key) const;
+
+    // Các core mà thread của pool ghim vào (để msquic đặt worker trên cùng các core)
+    const std::vector<uint16_t> &cpus() const { return cpus_; }
+
+private:
+    std::vector<std::unique_ptr<AsioService>> services_;
+    std::vector<uint16_t> cpus_;
+    bool running_ = false;
+};
@@ -0,0 +1,149 @@
+#include "distanceKernel.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#define DISTANCE_KERNEL_X86 1
+#include <immintrin.h>
+#endif
+
+static uint32_t withinRadiusScalar(int cx, int cy, const int *xs, const int *ys, uint32_t n, int radius, uint32_t *out)
+{
+    const int64_t radiusSq = int64_t(radius) * radius;
+    uint32_t count = 0;
+    for (uint32_t i = 0; i < n; ++i)
+    {
+        int64_t dx = int64_t(xs[i]) - cx;
+        int64_t dy = int64_t(ys[i]) - cy;
+        // Ghi vô điều kiện, chỉ tăng count khi trúng để tránh rẽ nhánh
+        out[count] = i;
+        count += (dx * dx + dy * dy < radiusSq);
+    }
+    return count;
+}
+
+#ifdef DISTANCE_KERNEL_X86
+
+// Ghi các bit đang bật của mask thành chỉ số base + bit
+static inline uint32_t appendMask(uint32_t mask, uint32_t base, uint32_t *out, uint32_t count)
+{
+    while (mask)
+    {
+        out[count++] = base + static_cast<uint32_t>(__builtin_ctz(mask));
+        mask &= mask - 1;
+    }
+    return count;
+}
+
+static uint32_t withinRadiusSse2(int cx, int cy, const int *xs, const int *ys, uint32_t n, int radius, uint32_t *out)
+{
+    const __m128 vcx = _mm_set1_ps(static_cast<float>(cx));
+    const __m128 vcy = _mm_set1_ps(static_cast<float>(cy));
+    const __m128 vr2 = _mm_set1_ps(static_cast<float>(radius) * static_cast<float>(radius));
+
+    uint32_t count = 0;
+    uint32_t i = 0;
+    for (; i + 4 <= n; i += 4)
+    {
+        __m128 dx = _mm_sub_ps(_mm_cvtepi32_ps(_mm_loadu_si128(reinterpret_cast<const __m128i *>(xs + i))), vcx);
+        __m128 dy = _mm_sub_ps(_mm_cvtepi32_ps(_mm_loadu_si128(reinterpret_cast<const __m128i *>(ys + i))), vcy);
+        __m128 d2 = _mm_add_ps(_mm_mul_ps(dx, dx), _mm_mul_ps(dy, dy));
+        uint32_t mask = static_cast<uint32_t>(_mm_movemask_ps(_mm_cmplt_ps(d2, vr2)));
+        count = appendMask(mask, i, out, count);
+    }
+    if (i < n)
+    {
+        uint32_t tail = withinRadiusScalar(cx, cy, xs + i, ys + i, n - i, radius, out + count);
+        for (uint32_t k = 0; k < tail; ++k)
+            out[count + k] += i;
+        count += tail;
+    }
+    return count;
+}
+
+__attribute__((target("avx2"))) static uint32_t withinRadiusAvx2(int cx, int cy, const int *xs, const int *ys, uint32_t n, int radius, uint32_t *out)
+{
+    const __m256 vcx = _mm256_set1_ps(static_cast<float>(cx));
+    const __m256 vcy = _mm256_set1_ps(static_cast<float>(cy));
+    const __m256 vr2 = _mm256_set1_ps(static_cast<float>(radius) * static_cast<float>(radius));
+
+    uint32_t count = 0;
+    uint32_t i = 0;
+    for (; i + 8 <= n; i += 8)
+    {
+        __m256 dx = _mm256_sub_ps(_mm256_cvtepi32_ps(_mm256_loadu_si256(reinterpret_cast<const __m256i *>(xs + i))), vcx);
+        __m256 dy = _mm256_sub_ps(_mm256_cvtepi32_ps(_mm256_loadu_si256(reinterpret_cast<const __m256i *>(ys + i))), vcy);
+        __m256 d2 = _mm256_add_ps(_mm256_mul_ps(dx, dx), _mm256_mul_ps(dy, dy));
+        uint32_t mask = static_cast<uint32_t>(_mm256_movemask_ps(_mm256_cmp_ps(d2, vr2, _CMP_LT_OQ)));
+        count = appendMask(mask, i, out, count);
+    }
+    if (i < n)
+    {
+        uint32_t tail = withinRadiusSse2(cx, cy, xs + i, ys + i, n - i, radius, out + count);
+        for (uint32_t k = 0; k < tail; ++k)
+            out[count + k] += i;
+        count += tail;
+    }
+    return count;
+}
+
+#endif // DISTANCE_KERNEL_X86
+
+namespace
+{
+    struct KernelChoice
+    {
+        WithinRadiusFn fn;
+        const char *name;
+    };
+
+    KernelChoice selectKernel()
+    {
+#ifdef DISTANCE_KERNEL_X86
+        __builtin_cpu_init();
+        if (__builtin_cpu_supports("avx2"))
+            return {withinRadiusAvx2, "avx2"};
+        if (__builtin_cpu_supports("sse2"))
+            return {withinRadiusSse2, "sse2"};
+#endif
+        return {withinRadiusScalar, "scalar"};
+    }
+
+    const KernelChoice &activeKernel()
+    {
+        static const KernelChoice choice = selectKernel();
+        return choice;
+    }
+}
+
+uint32_t withinRadius(int cx, int cy, const int *xs, const int *ys, uint32_t n, int radius, uint32_t *out)
+{
+    return activeKernel().fn(cx, cy, xs, ys, n, radius, out);
+}
+
+const char *withinRadiusBackend()
+{
+    return activeKernel().name;
+}
+
+WithinRadiusFn withinRadiusScalarFn()
+{
+    return withinRadiusScalar;
+}
+
+WithinRadiusFn withinRadiusSse2Fn()
+{
+#ifdef DISTANCE_KERNEL_X86
+    return withinRadiusSse2;
+#else
+    return nullptr;
+#endif
+}
+
+WithinRadiusFn withinRadiusAvx2Fn()
+{
+#ifdef DISTANCE_KERNEL_X86
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2"))
+        return withinRadiusAvx2;
+#endif
+    return nullptr;
+}
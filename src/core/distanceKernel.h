@@ -0,0 +1,23 @@
+#ifndef DISTANCE_KERNEL_H
+#define DISTANCE_KERNEL_H
+
+#include <cstdint>
+
+// Kernel khoảng cách theo lô: kiểm tra một điểm (cx, cy) với n ứng viên (xs, ys)
+// bằng bình phương khoảng cách, ghi vị trí (0..n-1) của các ứng viên có
+// dx*dx + dy*dy < radius*radius vào out và trả về số lượng. out phải đủ n phần tử.
+//
+// Phép tính dùng float: mọi khoảng cách gần ngưỡng va chạm đều là số nguyên nhỏ
+// nên kết quả trùng khớp với phép so sánh số nguyên.
+using WithinRadiusFn = uint32_t (*)(int cx, int cy, const int *xs, const int *ys, uint32_t n, int radius, uint32_t *out);
+
+// Bản được chọn lúc chạy (AVX2 > SSE2 > scalar) theo khả năng CPU
+uint32_t withinRadius(int cx, int cy, const int *xs, const int *ys, uint32_t n, int radius, uint32_t *out);
+const char *withinRadiusBackend();
+
+// Các bản cụ thể, dùng cho benchmark; trả về nullptr nếu CPU không hỗ trợ
+WithinRadiusFn withinRadiusScalarFn();
+WithinRadiusFn withinRadiusSse2Fn();
+WithinRadiusFn withinRadiusAvx2Fn();
+
+#endif // DISTANCE_KERNEL_H
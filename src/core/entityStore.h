@@ -0,0 +1,186 @@
+#ifndef ENTITY_STORE_H
+#define ENTITY_STORE_H
+
+#include <cstdint>
+#include <string>
+#include <utility>
+#include <vector>
+
+// Định danh thực thể: 20 bit thấp là slot, 12 bit cao là thế hệ.
+// Khi slot được tái sử dụng, thế hệ tăng lên nên ID cũ không còn hợp lệ.
+using EntityId = uint32_t;
+constexpr EntityId kInvalidEntity = 0;
+constexpr uint32_t kNoIndex = UINT32_MAX;
+
+// Định danh client do tầng mạng cấp (chính là ConnectionId của transport)
+using ClientId = uint64_t;
+
+// Bảng handle: ánh xạ EntityId -> vị trí trong các cột dữ liệu liền kề
+class HandleTable
+{
+public:
+    EntityId allocate(uint32_t denseIndex)
+    {
+        uint32_t slot;
+        if (!freeSlots_.empty())
+        {
+            slot = freeSlots_.back();
+            freeSlots_.pop_back();
+        }
+        else
+        {
+            slot = static_cast<uint32_t>(dense_.size());
+            dense_.push_back(kNoIndex);
+            generation_.push_back(1);
+        }
+        dense_[slot] = denseIndex;
+        return (static_cast<uint32_t>(generation_[slot]) << kSlotBits) | slot;
+    }
+
+    void release(EntityId id)
+    {
+        const uint32_t slot = id & kSlotMask;
+        dense_[slot] = kNoIndex;
+        // Thế hệ chạy từ 1..4095 để ID không bao giờ bằng kInvalidEntity
+        generation_[slot] = generation_[slot] >= kMaxGeneration ? 1 : generation_[slot] + 1;
+        freeSlots_.push_back(slot);
+    }
+
+    // Trả về kNoIndex nếu ID đã bị xoá hoặc không hợp lệ
+    uint32_t lookup(EntityId id) const
+    {
+        const uint32_t slot = id & kSlotMask;
+        if (slot >= dense_.size() || generation_[slot] != (id >> kSlotBits))
+            return kNoIndex;
+        return dense_[slot];
+    }
+
+    void relocate(EntityId id, uint32_t denseIndex)
+    {
+        dense_[id & kSlotMask] = denseIndex;
+    }
+
+private:
+    static constexpr uint32_t kSlotBits = 20;
+    static constexpr uint32_t kSlotMask = (1u << kSlotBits) - 1;
+    static constexpr uint16_t kMaxGeneration = (1u << (32 - kSlotBits)) - 1;
+
+    std::vector<uint32_t> dense_;
+    std::vector<uint16_t> generation_;
+    std::vector<uint32_t> freeSlots_;
+};
+
+// Xoá phần tử index khỏi mọi cột bằng cách đổi chỗ với phần tử cuối
+template <typename... Columns>
+void swapRemoveColumns(uint32_t index, Columns &...columns)
+{
+    (([&]
+      {
+        if (index + 1 != columns.size())
+            columns[index] = std::move(columns.back());
+        columns.pop_back(); }()),
+     ...);
+}
+
+// Người chơi: cột nóng (x, y, score) được duyệt mỗi tick,
+// cột lạnh (name, client) chỉ dùng khi join và khi gửi dữ liệu
+struct PlayerStore
+{
+    HandleTable handles;
+    std::vector<EntityId> id;
+    std::vector<int> x, y;
+    std::vector<int> score;
+    std::vector<ClientId> client;
+    std::vector<std::string> name;
+
+    uint32_t size() const { return static_cast<uint32_t>(id.size()); }
+    uint32_t indexOf(EntityId e) const { return handles.lookup(e); }
+
+    EntityId create(ClientId c, std::string n, int px, int py)
+    {
+        EntityId e = handles.allocate(size());
+        id.push_back(e);
+        x.push_back(px);
+        y.push_back(py);
+        score.push_back(0);
+        client.push_back(c);
+        name.push_back(std::move(n));
+        return e;
+    }
+
+    void removeAt(uint32_t i)
+    {
+        const EntityId e = id[i];
+        if (i + 1 != size())
+            handles.relocate(id.back(), i);
+        swapRemoveColumns(i, id, x, y, score, client, name);
+        handles.release(e);
+    }
+};
+
+// Vật phẩm trên bản đồ
+struct ItemStore
+{
+    HandleTable handles;
+    std::vector<EntityId> id;
+    std::vector<int> x, y;
+
+    uint32_t size() const { return static_cast<uint32_t>(id.size()); }
+    uint32_t indexOf(EntityId e) const { return handles.lookup(e); }
+
+    EntityId create(int px, int py)
+    {
+        EntityId e = handles.allocate(size());
+        id.push_back(e);
+        x.push_back(px);
+        y.push_back(py);
+        return e;
+    }
+
+    void removeAt(uint32_t i)
+    {
+        const EntityId e = id[i];
+        if (i + 1 != size())
+            handles.relocate(id.back(), i);
+        swapRemoveColumns(i, id, x, y);
+        handles.release(e);
+    }
+};
+
+// Đạn: người bắn được lưu bằng EntityId thay vì chuỗi tên
+struct BulletStore
+{
+    HandleTable handles;
+    std::vector<EntityId> id;
+    std::vector<int> x, y;
+    std::vector<double> dx, dy;
+    std::vector<EntityId> shooter;
+    std::vector<uint8_t> rewind; // số tick lùi lại khi xét trúng đạn (bù trễ của người bắn)
+
+    uint32_t size() const { return static_cast<uint32_t>(id.size()); }
+    uint32_t indexOf(EntityId e) const { return handles.lookup(e); }
+
+    EntityId create(EntityId owner, int px, int py, double vx, double vy, uint8_t rewindTicks = 0)
+    {
+        EntityId e = handles.allocate(size());
+        id.push_back(e);
+        x.push_back(px);
+        y.push_back(py);
+        dx.push_back(vx);
+        dy.push_back(vy);
+        shooter.push_back(owner);
+        rewind.push_back(rewindTicks);
+        return e;
+    }
+
+    void removeAt(uint32_t i)
+    {
+        const EntityId e = id[i];
+        if (i + 1 != size())
+            handles.relocate(id.back(), i);
+        swapRemoveColumns(i, id, x, y, dx, dy, shooter, rewind);
+        handles.release(e);
+    }
+};
+
+#endif // ENTITY_STORE_H
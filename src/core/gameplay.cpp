@@ -1,15 +1,36 @@
 #include "gameplay.h"
-#include <cstdlib>
-#include <ctime>
 #include <algorithm>
-#include "../quicServer/quicServer.h"
+#include <charconv>
+#include <filesystem>
 using json = nlohmann::json;
 
-Gameplay::Gameplay(quicServer &server, boost::asio::io_context &io)
-    : quic_server_(server), gameLoopTimer_(io)
+namespace
 {
-    srand(static_cast<unsigned int>(time(nullptr)));
-    lastItemSpawn_ = std::chrono::steady_clock::now();
+    uint64_t steadyNowNs()
+    {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(
+                   std::chrono::steady_clock::now().time_since_epoch())
+            .count();
+    }
+}
+
+Gameplay::Gameplay(Transport &transport, boost::asio::io_context &io, const GameplayConfig &config, uint32_t roomId)
+    : transport_(transport),
+      config_(config),
+      roomId_(roomId),
+      inputs_(static_cast<size_t>(std::max(16, config.inputQueueCapacity))),
+      shotCooldownTicks_(static_cast<uint32_t>((int64_t(config.shotCooldownMs) * std::max(1, config.tickRate) + 999) / 1000)),
+      // Mỗi phòng có seed riêng (ghi vào file log để replay), không dùng chung rand() toàn cục
+      world_(config, config.worldSeed ? config.worldSeed + roomId : std::random_device{}()),
+      playerViewGrid_(config.viewRadius),
+      itemViewGrid_(config.viewRadius),
+      bulletViewGrid_(config.viewRadius),
+      graceTicks_(static_cast<uint32_t>(int64_t(config.reconnectGraceMs) * std::max(1, config.tickRate) / 1000)),
+      tickPeriod_(std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+          std::chrono::nanoseconds(1000000000LL / std::max(1, config.tickRate)))),
+      gameLoopTimer_(io)
+{
+    world_.setLogging(config.logEvents);
 }
 
 Gameplay::~Gameplay()
@@ -17,69 +38,396 @@ Gameplay::~Gameplay()
     stopGameLoop();
 }
 
-void Gameplay::handleMessage(HQUIC stream, const std::string &msg)
+void Gameplay::handleMessage(ConnectionId conn, std::string_view msg)
+{
+    if (config_.logEvents)
+        std::cout << "[handleMessage] Received raw message:" << msg << std::endl;
+    auto j = json::parse(msg, nullptr, false);
+    if (j.is_discarded())
+    {
+        std::cerr << "[Gameplay] JSON parse error: msg=" << msg << "\n";
+        return;
+    }
+    handleJson(conn, j);
+}
+
+void Gameplay::handleJson(ConnectionId conn, const json &j)
 {
     try
     {
-        std::cout << "[handleMessage] Received raw message:" << msg << std::endl;
-        auto j = json::parse(msg);
         std::string action = j.value("action", "");
 
+        InputCommand cmd;
+        cmd.client = conn;
+        cmd.receivedNs = steadyNowNs();
+
         if (action == "join")
         {
-            std::string playerName = j.value("player", "");
-            addPlayer(stream, playerName);
-        }
-        else if (action == "move")
-        {
-            int newX = j.value("x", -1);
-            int newY = j.value("y", -1);
-            std::lock_guard<std::mutex> lock(players_mutex_);
-            auto it = players_.find(stream);
-            if (it != players_.end())
+            cmd.type = InputType::Join;
+            cmd.name = j.value("player", "");
+
+            // Client nối lại gửi kèm token nhận trong welcome; sai thì join mới
+            cmd.token = resumeToken(j);
+
+            // Client mới gửi danh sách encoding hỗ trợ; client cũ không gửi -> JSON
+            auto encodings = j.find("encodings");
+            if (encodings != j.end() && encodings->is_array())
             {
-                if (newX >= 0 && newY >= 0)
+                for (const auto &e : *encodings)
                 {
-                    it->second.x = newX;
-                    it->second.y = newY;
+                    if (e.is_string() && e.get<std::string>() == kBinaryEncodingName)
+                        cmd.encoding = WireEncoding::Binary;
                 }
             }
         }
+        else if (action == "move")
+        {
+            cmd.type = InputType::Move;
+            cmd.x = j.value("x", -1);
+            cmd.y = j.value("y", -1);
+            if (cmd.x < 0 || cmd.y < 0)
+                return;
+        }
+        else if (action == "ack")
+        {
+            // Client báo tick snapshot đã áp dụng, dùng làm mốc cho delta
+            int64_t tick = j.value("tick", int64_t(-1));
+            if (tick < 0 || tick > UINT32_MAX)
+                return;
+            cmd.type = InputType::Ack;
+            cmd.tick = static_cast<uint32_t>(tick);
+        }
         else if (action == "shoot")
         {
-            int x = j.value("x", -1);
-            int y = j.value("y", -1);
-            double dx = j.value("dx", 0.0);
-            double dy = j.value("dy", 0.0);
-            std::string shooterName = j.value("player", "");
+            cmd.type = InputType::Shoot;
+            cmd.x = j.value("x", -1);
+            cmd.y = j.value("y", -1);
+            cmd.dx = j.value("dx", 0.0);
+            cmd.dy = j.value("dy", 0.0);
+            if (cmd.x < 0 || cmd.y < 0 || (cmd.dx == 0.0 && cmd.dy == 0.0))
+                return;
+            // Tick snapshot client đang hiển thị khi bắn (tuỳ chọn) và RTT hiện tại để bù trễ
+            int64_t tick = j.value("tick", int64_t(0));
+            cmd.tick = tick > 0 && tick <= UINT32_MAX ? static_cast<uint32_t>(tick) : 0;
+            cmd.rttMicros = transport_.roundTripMicros(conn);
+        }
+        else
+        {
+            return;
+        }
+
+        enqueueInput(std::move(cmd));
+    }
+    catch (const std::exception &e)
+    {
+        std::cerr << "[Gameplay] Invalid message: " << e.what() << " msg=" << j.dump() << "\n";
+    }
+}
 
-            if (x >= 0 && y >= 0 && (dx != 0.0 || dy != 0.0) && !shooterName.empty())
+void Gameplay::enqueueInput(InputCommand &&cmd)
+{
+    // Đang có join/leave tràn thì join/leave sau cũng vào danh sách tràn để giữ thứ tự
+    const bool membership = cmd.type == InputType::Join || cmd.type == InputType::Leave;
+    if (!(membership && hasSpilled_.load(std::memory_order_acquire)) && inputs_.push(std::move(cmd)))
+        return;
+
+    // Hàng đợi đầy: bỏ lệnh di chuyển/bắn (lệnh sau sẽ thay thế), nhưng lệnh
+    // join/leave phải được áp dụng nên giữ lại cho tick kế tiếp
+    if (membership)
+    {
+        std::lock_guard<std::mutex> lock(spill_mutex_);
+        spilledInputs_.push_back(std::move(cmd));
+        hasSpilled_.store(true, std::memory_order_release);
+        return;
+    }
+    droppedInputs_.fetch_add(1, std::memory_order_relaxed);
+}
+
+void Gameplay::applyInputs()
+{
+    // Lệnh áp dụng ngay trước tick này; replay áp dụng lại đúng ở tick đó
+    const uint32_t tick = world_.tick() + 1;
+
+    // Chỉ lấy tối đa một vòng hàng đợi để luồng mạng không giữ tick mãi. Sau đó mới tới
+    // join/leave bị tràn: mọi join/leave trong hàng đợi đều cũ hơn chúng (khi danh sách
+    // tràn khác rỗng, join/leave mới không vào hàng đợi), nên thứ tự theo kết nối được giữ.
+    InputCommand cmd;
+    uint64_t applied = 0;
+    uint64_t throttledShots = 0;
+    size_t n = inputs_.capacity();
+    size_t spilled = 0;
+    bool spillTaken = false;
+    spillDrain_.clear();
+    for (;;)
+    {
+        if (n > 0 && inputs_.pop(cmd))
+        {
+            --n;
+        }
+        else
+        {
+            n = 0;
+            if (!spillTaken && hasSpilled_.load(std::memory_order_acquire))
             {
-                createBullet(shooterName, x, y, dx, dy);
+                std::lock_guard<std::mutex> lock(spill_mutex_);
+                spillDrain_.swap(spilledInputs_);
+                hasSpilled_.store(false, std::memory_order_release);
             }
+            spillTaken = true;
+            if (spilled == spillDrain_.size())
+                break;
+            cmd = std::move(spillDrain_[spilled++]);
+        }
+        ++applied;
+        if (cmd.type == InputType::Ack)
+        {
+            // Ack chỉ ảnh hưởng việc đồng bộ, không thay đổi thế giới nên không ghi log
+            EntityId e = world_.playerOf(cmd.client);
+            if (e != kInvalidEntity && cmd.tick <= world_.tick())
+                clients_[e].history.acknowledge(cmd.tick);
+            continue;
+        }
+
+        // Mất kết nối trong thời gian chờ: người chơi ở lại thế giới, chưa có gì thay đổi
+        // nên chưa ghi log; Leave thật được ghi khi hết thời gian chờ
+        if (cmd.type == InputType::Leave && detachPlayer(cmd, tick))
+            continue;
+
+        // Join kèm token hợp lệ thành Resume: nhận lại người chơi cũ thay vì tạo người mới
+        const bool resumed = cmd.type == InputType::Join && resolveResume(cmd);
+
+        if (cmd.type == InputType::Shoot && shotCooldownTicks_ > 0)
+        {
+            // Bắn nhanh hơn cooldown: bỏ trước khi ghi log nên replay cũng không có phát này
+            EntityId e = world_.playerOf(cmd.client);
+            if (e == kInvalidEntity)
+                continue;
+            ClientReplication &client = clients_[e];
+            if (tick < client.nextShotTick)
+            {
+                ++throttledShots;
+                continue;
+            }
+            client.nextShotTick = tick + shotCooldownTicks_;
+        }
+
+        if (cmd.type == InputType::Shoot)
+            cmd.rewind = rewindTicks(cmd, tick);
+
+        recordInput(cmd, tick);
+        EntityId e = world_.apply(cmd);
+        if (e == kInvalidEntity)
+            continue;
+
+        if (cmd.type == InputType::Join || cmd.type == InputType::Resume)
+        {
+            // Kết nối mới chưa có gì: bắt đầu lại từ snapshot đầy đủ
+            ClientReplication &client = clients_[e];
+            if (resumed)
+            {
+                revokeToken(client.token);
+                if (client.detachedUntil)
+                    detached_.erase(std::find(detached_.begin(), detached_.end(), e));
+                else
+                    transport_.disconnect(cmd.previous); // kết nối cũ chưa báo đóng (đổi mạng)
+                client = ClientReplication{};
+            }
+            client.encoding = cmd.encoding;
+            const PlayerStore &players = world_.players();
+            sendWelcomeMessage(cmd.client, players.name[players.indexOf(e)], cmd.encoding, issueToken(e), resumed);
+        }
+        else if (cmd.type == InputType::Leave)
+        {
+            revokeToken(clients_[e].token);
+            clients_.erase(e);
         }
     }
-    catch (const std::exception &e)
+
+    expireDetached(tick);
+
+    std::lock_guard<std::mutex> lock(stats_mutex_);
+    stats_.inputs += applied;
+    stats_.throttledShots += throttledShots;
+    stats_.droppedInputs = droppedInputs_.load(std::memory_order_relaxed);
+}
+
+void Gameplay::recordInput(const InputCommand &cmd, uint32_t tick)
+{
+    if (recorder_.isOpen())
+        recorder_.recordInput(tick, cmd.receivedNs > recordStartNs_ ? cmd.receivedNs - recordStartNs_ : 0, cmd);
+}
+
+uint64_t Gameplay::issueToken(EntityId e)
+{
+    // random_device (không phải rng_ của thế giới): token không đoán được và không làm
+    // lệch mô phỏng tất định
+    uint64_t token = 0;
     {
-        std::cerr << "[Gameplay] JSON parse error: " << e.what() << " msg=" << msg << "\n";
+        std::lock_guard<std::mutex> lock(tokens_mutex_);
+        while (token == 0 || tokens_.count(token))
+            token = (uint64_t(tokenSource_()) << 32) | tokenSource_();
+        tokens_.emplace(token, e);
     }
+    clients_[e].token = token;
+    return token;
 }
 
-void Gameplay::handlePlayerConnected(HQUIC /*conn*/, HQUIC stream)
+void Gameplay::revokeToken(uint64_t token)
 {
-    std::cout << "[Gameplay] Player stream started: " << stream << "\n";
-    // Đợi client gửi tin nhắn "join" để thêm người chơi
+    std::lock_guard<std::mutex> lock(tokens_mutex_);
+    tokens_.erase(token);
 }
 
-void Gameplay::handlePlayerDisconnected(HQUIC stream)
+uint64_t Gameplay::resumeToken(const json &j)
 {
-    removePlayer(stream);
-    std::cout << "[Gameplay] Player disconnected stream=" << stream << "\n";
+    auto it = j.find("token");
+    if (it == j.end() || !it->is_string())
+        return 0;
+    const std::string &hex = it->get_ref<const std::string &>();
+    uint64_t token = 0;
+    std::from_chars(hex.data(), hex.data() + hex.size(), token, 16);
+    return token;
+}
+
+bool Gameplay::hasResumeToken(uint64_t token)
+{
+    if (token == 0)
+        return false;
+    std::lock_guard<std::mutex> lock(tokens_mutex_);
+    return tokens_.count(token) != 0;
+}
+
+bool Gameplay::detachPlayer(const InputCommand &cmd, uint32_t tick)
+{
+    if (graceTicks_ == 0)
+        return false;
+    EntityId e = world_.playerOf(cmd.client);
+    if (e == kInvalidEntity)
+        return false;
+    ClientReplication &client = clients_[e];
+    if (client.detachedUntil)
+        return true;
+    client.detachedUntil = tick + graceTicks_;
+    detached_.push_back(e);
+    return true;
+}
+
+bool Gameplay::resolveResume(InputCommand &cmd)
+{
+    if (cmd.token == 0)
+        return false;
+    EntityId e;
+    {
+        std::lock_guard<std::mutex> lock(tokens_mutex_);
+        auto it = tokens_.find(cmd.token);
+        if (it == tokens_.end())
+            return false;
+        e = it->second;
+    }
+    const PlayerStore &players = world_.players();
+    const uint32_t i = players.indexOf(e);
+    if (i == kNoIndex)
+        return false;
+    cmd.type = InputType::Resume;
+    cmd.previous = players.client[i];
+    return true;
+}
+
+void Gameplay::expireDetached(uint32_t tick)
+{
+    // Hết thời gian chờ: xoá người chơi như một Leave bình thường (có ghi log)
+    for (size_t k = 0; k < detached_.size();)
+    {
+        const EntityId e = detached_[k];
+        ClientReplication &client = clients_[e];
+        if (client.detachedUntil > tick)
+        {
+            ++k;
+            continue;
+        }
+        detached_[k] = detached_.back();
+        detached_.pop_back();
+
+        const PlayerStore &players = world_.players();
+        InputCommand leave;
+        leave.type = InputType::Leave;
+        leave.client = players.client[players.indexOf(e)];
+        leave.receivedNs = steadyNowNs();
+        recordInput(leave, tick);
+        world_.apply(leave);
+        revokeToken(client.token);
+        clients_.erase(e);
+    }
+}
+
+uint8_t Gameplay::rewindTicks(const InputCommand &cmd, uint32_t tick) const
+{
+    const uint32_t maxRewind = world_.maxRewindTicks();
+    if (maxRewind == 0)
+        return 0;
+
+    // Client thấy snapshot trễ nửa RTT, lệnh bắn tới server trễ thêm nửa RTT nữa
+    const int64_t periodNs = std::chrono::duration_cast<std::chrono::nanoseconds>(tickPeriod_).count();
+    const uint32_t rttTicks = static_cast<uint32_t>((int64_t(cmd.rttMicros) * 1000 + periodNs / 2) / periodNs);
+
+    uint32_t rewind = rttTicks;
+    if (cmd.tick > 0 && cmd.tick < tick)
+    {
+        // Tin tick client báo (gồm cả độ trễ nội suy phía client), nhưng khi đo được
+        // RTT thì không cho lùi xa hơn RTT cộng một khoảng dung sai
+        rewind = tick - cmd.tick;
+        if (cmd.rttMicros > 0)
+            rewind = std::min(rewind, rttTicks + kRewindToleranceTicks);
+    }
+    return static_cast<uint8_t>(std::min(rewind, maxRewind));
+}
+
+void Gameplay::openRecording()
+{
+    if (config_.recordDir.empty())
+        return;
+
+    std::error_code ec;
+    std::filesystem::create_directories(config_.recordDir, ec);
+
+    const uint64_t unixMs = std::chrono::duration_cast<std::chrono::milliseconds>(
+                                std::chrono::system_clock::now().time_since_epoch())
+                                .count();
+    const std::string path = config_.recordDir + "/room" + std::to_string(roomId_) + "-" + std::to_string(unixMs) + ".rec";
+
+    ReplayHeader header;
+    header.seed = world_.seed();
+    header.tickRate = static_cast<uint32_t>(config_.tickRate);
+    header.roomId = roomId_;
+    header.startUnixMs = unixMs;
+    header.lagCompensationMs = static_cast<uint32_t>(std::max(0, config_.lagCompensationMs));
+    if (recorder_.open(path, header))
+    {
+        recordStartNs_ = steadyNowNs();
+        std::cout << "[Gameplay] Recording room " << roomId_ << " to " << path << "\n";
+    }
+}
+
+void Gameplay::handlePlayerDisconnected(ConnectionId conn)
+{
+    InputCommand cmd;
+    cmd.type = InputType::Leave;
+    cmd.client = conn;
+    cmd.receivedNs = steadyNowNs();
+    enqueueInput(std::move(cmd));
+    if (config_.logEvents)
+        std::cout << "[Gameplay] Player disconnected conn=" << conn << "\n";
 }
 
 void Gameplay::startGameLoop()
 {
     gameRunning_ = true;
+    // Lịch tick tính từ bây giờ: timer mới tạo có expiry ở mốc 0 của steady_clock,
+    // nếu cộng dồn từ đó vòng lặp sẽ chạy bù liên tục
+    auto now = std::chrono::steady_clock::now();
+    gameLoopTimer_.expires_at(now);
+    lastStatsLog_ = now;
+    openRecording();
     gameLoop(boost::system::error_code()); // Bắt đầu vòng lặp đầu tiên
 }
 
@@ -87,220 +435,374 @@ void Gameplay::stopGameLoop()
 {
     gameRunning_ = false;
     gameLoopTimer_.cancel();
+    recorder_.close(world_.tick());
 }
 
-void Gameplay::gameLoop(const boost::system::error_code &error)
+TickStats Gameplay::tickStats()
 {
-    auto now = std::chrono::steady_clock::now();
+    std::lock_guard<std::mutex> lock(stats_mutex_);
+    return stats_;
+}
 
+void Gameplay::gameLoop(const boost::system::error_code &error)
+{
     if (error == boost::asio::error::operation_aborted)
         return;
 
     if (!gameRunning_)
         return;
 
+    runTick();
+
+    const auto tickEnd = std::chrono::steady_clock::now();
+    scheduleNextTick(tickEnd);
+
+    if (config_.statsLogIntervalSec > 0 && tickEnd - lastStatsLog_ >= std::chrono::seconds(config_.statsLogIntervalSec))
+    {
+        // Histogram chỉ tính trong một chu kỳ log, các bộ đếm thì cộng dồn
+        std::lock_guard<std::mutex> lock(stats_mutex_);
+        std::cout << "[Gameplay] room " << roomId_ << " tick stats: "
+                  << stats_.summary(std::chrono::duration_cast<std::chrono::nanoseconds>(tickPeriod_).count()) << "\n";
+        for (auto &h : stats_.phases)
+            h.reset();
+        lastStatsLog_ = tickEnd;
+    }
+}
+
+void Gameplay::runTick()
+{
+    using clock = std::chrono::steady_clock;
+
+    // Đo từng pha bằng đồng hồ đơn điệu, ghi vào histogram một lần cuối tick
+    std::array<uint64_t, static_cast<size_t>(TickPhase::Count)> phaseNs{};
+    const auto tickStart = clock::now();
+    auto phaseStart = tickStart;
+    auto endPhase = [&](TickPhase phase)
+    {
+        auto t = clock::now();
+        phaseNs[static_cast<size_t>(phase)] = std::chrono::duration_cast<std::chrono::nanoseconds>(t - phaseStart).count();
+        phaseStart = t;
+    };
+
+    // Áp dụng lệnh của client theo đúng thứ tự nhận, trước mọi logic của tick
+    applyInputs();
+    endPhase(TickPhase::Input);
+
     // Logic game
-    checkItemCollection();
-    updateBullets();
-    checkBulletCollisions();
+    world_.step(endPhase);
+
+    // Checksum mỗi giây để replay kiểm tra kết quả còn khớp
+    if (recorder_.isOpen() && world_.tick() % static_cast<uint32_t>(config_.tickRate) == 0)
+        recorder_.recordChecksum(world_.tick(), world_.checksum());
+
+    // Khi đang giảm tần suất (degrade), chỉ broadcast mỗi broadcastDivisor_ tick
+    const bool broadcast = world_.tick() % broadcastDivisor_ == 0;
+    if (broadcast)
+        broadcastGameState();
+    // Mọi tin của tick này (welcome, snapshot) tới cùng một client đi chung một lần gửi
+    transport_.flush(world_.players().client);
+    endPhase(TickPhase::Broadcast);
+
+    const auto tickEnd = clock::now();
+    phaseNs[static_cast<size_t>(TickPhase::Total)] = std::chrono::duration_cast<std::chrono::nanoseconds>(tickEnd - tickStart).count();
 
-    if (now - lastItemSpawn_ >= std::chrono::seconds(5))
     {
-        spawnItem();
-        lastItemSpawn_ = now;
+        std::lock_guard<std::mutex> lock(stats_mutex_);
+        for (size_t p = 0; p < phaseNs.size(); ++p)
+        {
+            if (p != static_cast<size_t>(TickPhase::Broadcast) || broadcast)
+                stats_.phases[p].record(phaseNs[p]);
+        }
+        stats_.ticks++;
+        if (!broadcast)
+            stats_.skippedBroadcasts++;
     }
+}
 
-    broadcastGameState();
+void Gameplay::scheduleNextTick(std::chrono::steady_clock::time_point now)
+{
+    auto next = gameLoopTimer_.expiry() + tickPeriod_;
+
+    if (now > next)
+    {
+        // Quá hạn: tick kế tiếp lẽ ra đã phải bắt đầu
+        const int64_t behind = (now - next) / tickPeriod_;
+        uint64_t skipped = 0;
+
+        if (config_.overrunPolicy == OverrunPolicy::Skip)
+        {
+            // Bỏ mọi tick đã lỡ, tick kế tiếp chạy đúng lịch sau thời điểm hiện tại
+            skipped = static_cast<uint64_t>(behind) + 1;
+        }
+        else if (behind > config_.maxCatchUpTicks)
+        {
+            // Chạy bù liên tiếp nhưng không quá maxCatchUpTicks tick
+            skipped = static_cast<uint64_t>(behind - config_.maxCatchUpTicks);
+        }
+        next += tickPeriod_ * static_cast<int64_t>(skipped);
+
+        if (config_.overrunPolicy == OverrunPolicy::DegradeBroadcast)
+        {
+            broadcastDivisor_ = std::min<uint32_t>(broadcastDivisor_ * 2, static_cast<uint32_t>(config_.maxBroadcastDivisor));
+            healthyTicks_ = 0;
+        }
+
+        std::lock_guard<std::mutex> lock(stats_mutex_);
+        stats_.overruns++;
+        stats_.skippedTicks += skipped;
+        stats_.broadcastDivisor = broadcastDivisor_;
+    }
+    else if (broadcastDivisor_ > 1 && ++healthyTicks_ >= static_cast<uint32_t>(config_.tickRate) * 2)
+    {
+        // Ổn định liên tục khoảng 2 giây thì tăng dần tần suất broadcast trở lại
+        broadcastDivisor_ /= 2;
+        healthyTicks_ = 0;
+        std::lock_guard<std::mutex> lock(stats_mutex_);
+        stats_.broadcastDivisor = broadcastDivisor_;
+    }
 
     // Hẹn giờ lặp tiếp
-    gameLoopTimer_.expires_at(gameLoopTimer_.expiry() + std::chrono::milliseconds(50));
+    gameLoopTimer_.expires_at(next);
     gameLoopTimer_.async_wait([this](const boost::system::error_code &e)
                               { gameLoop(e); });
 }
 
 void Gameplay::broadcastGameState()
 {
-    std::vector<Player> playerSnapshot;
-    std::vector<HQUIC> playerStreams;
+    const PlayerStore &players = world_.players();
+    const ItemStore &items = world_.items();
+    const BulletStore &bullets = world_.bullets();
+    if (players.size() == 0)
+        return;
+
+    std::vector<std::pair<ClientId, std::string>> outgoing;
+    std::vector<ClientId> sharedTargets[2];
+    std::string sharedFull[2];
 
+    // Phần toàn cục giống nhau cho mọi client nên chỉ dựng một lần mỗi tick
+    buildLeaderboard(leaderboard_);
+
+    // Phần cố định của snapshot (đầu và bảng xếp hạng) theo từng định dạng, trừ khỏi
+    // ngân sách trước khi chọn thực thể
+    size_t fixedBytes[2] = {0, 0};
+    for (WireEncoding e : {WireEncoding::Json, WireEncoding::Binary})
     {
-        std::lock_guard<std::mutex> lock(players_mutex_);
-        for (auto &kv : players_)
+        const SnapshotCost &cost = snapshotCost(e);
+        size_t fixed = cost.header;
+        for (const auto &entry : leaderboard_)
         {
-            playerSnapshot.push_back(kv.second);
-            playerStreams.push_back(kv.first);
+            uint32_t i = players.indexOf(entry.id);
+            fixed += cost.leaderboardEntry + (i != kNoIndex ? players.name[i].size() : 0);
         }
+        fixedBytes[static_cast<size_t>(e)] = fixed;
     }
+    uint64_t deferred = 0;
 
-    if (playerSnapshot.empty())
-        return;
-
-    std::vector<Item> itemSnapshot;
+    if (config_.viewRadius > 0)
     {
-        std::lock_guard<std::mutex> lock(items_mutex_);
-        items_.erase(std::remove_if(items_.begin(), items_.end(), [](const Item &it)
-                                    { return !it.active; }),
-                     items_.end());
-        itemSnapshot = items_;
+        playerViewGrid_.clear();
+        for (uint32_t i = 0; i < players.size(); ++i)
+            playerViewGrid_.insert(i, players.x[i], players.y[i]);
+        playerViewGrid_.build();
+
+        itemViewGrid_.clear();
+        for (uint32_t i = 0; i < items.size(); ++i)
+            itemViewGrid_.insert(i, items.x[i], items.y[i]);
+        itemViewGrid_.build();
+
+        bulletViewGrid_.clear();
+        for (uint32_t i = 0; i < bullets.size(); ++i)
+            bulletViewGrid_.insert(i, bullets.x[i], bullets.y[i]);
+        bulletViewGrid_.build();
     }
 
-    std::vector<Bullet> bulletSnapshot;
+    // Khi tắt lọc vùng quan tâm, snapshot đầy đủ giống nhau cho mọi client
+    // chưa ack cùng định dạng: chỉ mã hoá một lần và broadcast một buffer chung
+    for (uint32_t p = 0; p < players.size(); ++p)
     {
-        std::lock_guard<std::mutex> lock(bullets_mutex_);
-        bullets_.erase(std::remove_if(bullets_.begin(), bullets_.end(), [](const Bullet &b)
-                                      { return !b.active; }),
-                       bullets_.end());
-        bulletSnapshot = bullets_;
-    }
+        ClientReplication &client = clients_[players.id[p]];
+        if (client.detachedUntil)
+            continue; // đang chờ nối lại, kết nối cũ đã đóng
+        const ClientFrame *base = client.history.baseline(world_.tick());
+        ClientFrame &frame = client.history.beginFrame(world_.tick());
+        const size_t encodingIndex = static_cast<size_t>(client.encoding);
+
+        buildFrame(players.x[p], players.y[p], frame);
+
+        // Client nhận snapshot qua datagram thì snapshot phải vừa một datagram
+        size_t budget = config_.snapshotBudgetBytes > 0 ? static_cast<size_t>(config_.snapshotBudgetBytes) : SIZE_MAX;
+        const size_t datagramMax = transport_.maxDatagramSize(players.client[p]);
+        if (datagramMax > 0)
+            budget = std::min(budget, datagramMax);
+
+        // Có ngân sách: frame ghi lại là mốc cộng phần thay đổi được chọn (đúng thứ client
+        // sẽ có), phần bị hoãn lại xuất hiện trong delta của các tick sau. Chỉ áp khi client
+        // đã ack một mốc: snapshot đầy đủ được client dùng để thay toàn bộ trạng thái nên
+        // luôn gửi đủ (client không ack, như client JSON cũ, nếu không sẽ thấy thực thể bị
+        // hoãn biến mất rồi hiện lại mỗi tick).
+        bool complete = true;
+        if (budget != SIZE_MAX && base)
+        {
+            const size_t fixed = fixedBytes[encodingIndex];
+            const int falloff = config_.viewRadius > 0 ? config_.viewRadius : 1000;
+            auto sel = client.priority.select(base, frame, players.id[p], players.x[p], players.y[p], falloff,
+                                              budget > fixed ? budget - fixed : 0, snapshotCost(client.encoding), players);
+            deferred += sel.deferred;
+            complete = sel.deferred == 0;
+        }
 
-    // Gửi dữ liệu trạng thái
-    json state_json = json::object();
-    state_json["players"] = json::array();
-    for (const auto &p : playerSnapshot)
-        state_json["players"].push_back({{"name", p.name}, {"x", p.x}, {"y", p.y}, {"score", p.score}});
+        const bool shareable = !base && config_.viewRadius <= 0 && complete;
+        if (shareable && !sharedTargets[encodingIndex].empty())
+        {
+            sharedTargets[encodingIndex].push_back(players.client[p]);
+            continue;
+        }
 
-    state_json["items"] = json::array();
-    for (const auto &it : itemSnapshot)
-        state_json["items"].push_back({{"id", it.id}, {"x", it.x}, {"y", it.y}});
+        buildSnapshot(frame, base);
+        if (client.encoding == WireEncoding::Binary)
+            encodeSnapshotBinary(snapshot_, players, wireBuffer_);
+        else
+            encodeSnapshotJson(snapshot_, players, wireBuffer_);
 
-    state_json["bullets"] = json::array();
-    for (const auto &b : bulletSnapshot)
-        state_json["bullets"].push_back({{"id", b.id}, {"x", b.x}, {"y", b.y}, {"dx", b.dx}, {"dy", b.dy}, {"shooter", b.shooter_name}});
+        if (shareable)
+        {
+            sharedFull[encodingIndex] = wireBuffer_;
+            sharedTargets[encodingIndex].push_back(players.client[p]);
+            continue;
+        }
+        outgoing.emplace_back(players.client[p], wireBuffer_);
+    }
 
-    std::string msg = state_json.dump() + "\n";
+    // Snapshot riêng từng client đi kênh không tin cậy: mất một snapshot thì client chỉ
+    // không ack tick đó, delta sau vẫn tính từ tick đã ack nên không cần gửi lại
+    for (auto &[client, msg] : outgoing)
+    {
+        transport_.sendUnreliable(client, std::move(msg));
+    }
+    for (size_t e = 0; e < 2; ++e)
+    {
+        if (!sharedTargets[e].empty())
+            transport_.broadcastUnreliable(sharedTargets[e], std::move(sharedFull[e]));
+    }
 
-    for (auto &stream : playerStreams)
+    if (deferred)
     {
-        quic_server_.sendMessage(stream, msg);
+        std::lock_guard<std::mutex> lock(stats_mutex_);
+        stats_.deferredUpdates += deferred;
     }
 }
 
-void Gameplay::addPlayer(HQUIC stream, const std::string &name)
+void Gameplay::buildFrame(int x, int y, ClientFrame &frame)
 {
-    std::lock_guard<std::mutex> lock(players_mutex_);
-    if (players_.find(stream) != players_.end())
-        return;
-    Player p;
-    p.x = 50 + (rand() % 500);
-    p.y = 50 + (rand() % 300);
-    p.name = name.empty() ? ("P" + std::to_string(nextItemId_++)) : name;
-    p.stream = stream;
-    players_.emplace(stream, std::move(p));
-    std::cout << "[Gameplay] Added player " << players_[stream].name << "\n";
-    sendWelcomeMessage(stream, players_[stream].name);
+    const PlayerStore &players = world_.players();
+    const ItemStore &items = world_.items();
+    const BulletStore &bullets = world_.bullets();
+
+    auto byId = [](const auto &a, const auto &b)
+    { return a.id < b.id; };
+
+    collectVisible(playerViewGrid_, x, y, visible_, players.size());
+    for (uint32_t i : visible_)
+        frame.players.push_back({players.id[i], players.x[i], players.y[i], players.score[i]});
+    std::sort(frame.players.begin(), frame.players.end(), byId);
+
+    collectVisible(itemViewGrid_, x, y, visible_, items.size());
+    for (uint32_t i : visible_)
+        frame.items.push_back({items.id[i], items.x[i], items.y[i]});
+    std::sort(frame.items.begin(), frame.items.end(), byId);
+
+    collectVisible(bulletViewGrid_, x, y, visible_, bullets.size());
+    for (uint32_t i : visible_)
+        frame.bullets.push_back({bullets.id[i], bullets.x[i], bullets.y[i], bullets.dx[i], bullets.dy[i], bullets.shooter[i]});
+    std::sort(frame.bullets.begin(), frame.bullets.end(), byId);
 }
 
-void Gameplay::removePlayer(HQUIC stream)
+void Gameplay::collectVisible(const SpatialGrid &grid, int x, int y, std::vector<uint32_t> &out, uint32_t total)
 {
-    std::lock_guard<std::mutex> lock(players_mutex_);
-    auto it = players_.find(stream);
-    if (it != players_.end())
+    // Tắt lọc vùng quan tâm: mọi thực thể đều thấy được
+    if (config_.viewRadius <= 0)
     {
-        std::cout << "[Gameplay] Removing player " << it->second.name << "\n";
-        players_.erase(it);
+        out.resize(total);
+        for (uint32_t i = 0; i < total; ++i)
+            out[i] = i;
+        return;
     }
-}
 
-void Gameplay::spawnItem()
-{
-    std::lock_guard<std::mutex> lock(items_mutex_);
-    Item it;
-    it.id = nextItemId_++;
-    it.x = 50 + (rand() % 500);
-    it.y = 50 + (rand() % 300);
-    it.active = true;
-    items_.push_back(it);
-    std::cout << "[Gameplay] Spawned item " << it.id << "\n";
+    grid.gather(x, y, config_.viewRadius, candidates_);
+    hits_.resize(candidates_.size());
+    uint32_t n = withinRadius(x, y, candidates_.x.data(), candidates_.y.data(),
+                              candidates_.size(), config_.viewRadius, hits_.data());
+    out.resize(n);
+    for (uint32_t k = 0; k < n; ++k)
+        out[k] = candidates_.index[hits_[k]];
 }
 
-void Gameplay::checkItemCollection()
+void Gameplay::buildSnapshot(const ClientFrame &frame, const ClientFrame *base)
 {
-    std::lock_guard<std::mutex> playersLock(players_mutex_);
-    std::lock_guard<std::mutex> itemsLock(items_mutex_);
+    snapshot_.clear();
+    snapshot_.tick = frame.tick;
+    snapshot_.playerCount = world_.players().size();
 
-    for (auto &pkv : players_)
+    if (!base)
     {
-        for (auto &it : items_)
-        {
-            if (!it.active)
-                continue;
-            int dx = pkv.second.x - it.x;
-            int dy = pkv.second.y - it.y;
-            int dist = static_cast<int>(std::sqrt(dx * dx + dy * dy));
-            if (dist < 20)
-            {
-                it.active = false;
-                pkv.second.score += 1;
-                std::cout << "[Gameplay] Player " << pkv.second.name << " collected " << it.id << "\n";
-            }
-        }
+        // Chưa có mốc hợp lệ: gửi snapshot đầy đủ
+        for (const auto &st : frame.players)
+            snapshot_.players.push_back({st, true});
+        snapshot_.items = frame.items;
+        for (const auto &st : frame.bullets)
+            snapshot_.bullets.push_back({st, true});
     }
-}
-
-void Gameplay::createBullet(const std::string &shooterName, int x, int y, int dx, int dy)
-{
-    std::lock_guard<std::mutex> lock(bullets_mutex_);
-    Bullet b;
-    b.id = nextBulletId_++;
-    b.x = x;
-    b.y = y;
-    b.dx = dx;
-    b.dy = dy;
-    b.shooter_name = shooterName;
-    b.active = true;
-    bullets_.push_back(b);
-    std::cout << "[Gameplay] Bullet " << b.id << " from " << shooterName << "\n";
-}
-
-void Gameplay::updateBullets()
-{
-    std::lock_guard<std::mutex> lock(bullets_mutex_);
-    for (auto &b : bullets_)
+    else
     {
-        if (!b.active)
-            continue;
-        b.x += b.dx * b.speed;
-        b.y += b.dy * b.speed;
-        if (b.x < 0 || b.x > 2000 || b.y < 0 || b.y > 2000)
-            b.active = false;
+        // Chỉ gửi thực thể mới, thay đổi hoặc bị xoá so với tick client đã ack
+        snapshot_.baseline = base->tick;
+        diffStates(base->players, frame.players, [&](const PlayerState &st, bool created)
+                   { snapshot_.players.push_back({st, created}); }, [&](EntityId id)
+                   { snapshot_.removedPlayers.push_back(id); });
+        diffStates(base->items, frame.items, [&](const ItemState &st, bool)
+                   { snapshot_.items.push_back(st); }, [&](EntityId id)
+                   { snapshot_.removedItems.push_back(id); });
+        diffStates(base->bullets, frame.bullets, [&](const BulletState &st, bool created)
+                   { snapshot_.bullets.push_back({st, created}); }, [&](EntityId id)
+                   { snapshot_.removedBullets.push_back(id); });
     }
+
+    snapshot_.leaderboard = leaderboard_;
 }
 
-void Gameplay::checkBulletCollisions()
+void Gameplay::buildLeaderboard(std::vector<SnapshotMessage::LeaderboardEntry> &out) const
 {
-    std::lock_guard<std::mutex> playersLock(players_mutex_);
-    std::lock_guard<std::mutex> bulletsLock(bullets_mutex_);
-
-    for (auto &b : bullets_)
-    {
-        if (!b.active)
-            continue;
-        for (auto &pkv : players_)
-        {
-            if (pkv.second.name == b.shooter_name)
-                continue;
-            int dx = pkv.second.x - b.x;
-            int dy = pkv.second.y - b.y;
-            int dist = static_cast<int>(std::sqrt(dx * dx + dy * dy));
-            if (dist < 15)
-            {
-                b.active = false;
-                pkv.second.score = std::max(0, pkv.second.score - 1);
-                std::cout << "[Gameplay] Player " << pkv.second.name << " hit by " << b.shooter_name << "\n";
-                break;
-            }
-        }
-    }
+    const PlayerStore &players = world_.players();
+
+    const uint32_t count = std::min<uint32_t>(players.size(), std::max(0, config_.leaderboardSize));
+    std::vector<uint32_t> order(players.size());
+    for (uint32_t i = 0; i < players.size(); ++i)
+        order[i] = i;
+    std::partial_sort(order.begin(), order.begin() + count, order.end(), [&players](uint32_t a, uint32_t b)
+                      { return players.score[a] > players.score[b]; });
+
+    out.clear();
+    for (uint32_t k = 0; k < count; ++k)
+        out.push_back({players.id[order[k]], players.score[order[k]]});
 }
 
-void Gameplay::sendWelcomeMessage(HQUIC stream, const std::string &playerName)
+void Gameplay::sendWelcomeMessage(ClientId client, const std::string &playerName, WireEncoding encoding, uint64_t token, bool resumed)
 {
     {
+        char hex[17];
+        *std::to_chars(hex, hex + 16, token, 16).ptr = '\0';
+
         nlohmann::json j;
         j["action"] = "welcome";
         j["player"] = playerName;
+        j["room"] = roomId_;
+        // Gửi lại {"action":"join","room":..,"token":..} khi nối lại để giữ người chơi
+        j["token"] = hex;
+        j["resumed"] = resumed;
+        // Báo định dạng snapshot server sẽ dùng cho client này
+        j["encoding"] = encoding == WireEncoding::Binary ? kBinaryEncodingName : "json";
 
         std::string msg = j.dump() + "\n"; // ensure newline separator
-        quic_server_.sendMessage(stream, msg);
+        transport_.sendMessage(client, std::move(msg), TrafficClass::Control);
     }
-}
\ No newline at end of file
+}
@@ -2,96 +2,160 @@
 #define GAMEPLAY_H
 
 #include <iostream>
-#include <map>
+#include <unordered_map>
 #include <vector>
 #include <string>
+#include <string_view>
 #include <mutex>
 #include <memory>
 #include <atomic>
 #include <chrono>
 #include <cmath>
+#include <random>
+#include <boost/asio/io_context.hpp>
+#include <boost/asio/post.hpp>
 #include <boost/asio/steady_timer.hpp>
-#include "../quicServer/quicServer.h"
+#include "distanceKernel.h"
+#include "../transport/transport.h"
+#include "gameplayConfig.h"
+#include "mpscQueue.h"
+#include "priorityAccumulator.h"
+#include "replayLog.h"
+#include "snapshot.h"
+#include "snapshotCodec.h"
+#include "tickStats.h"
+#include "spatialGrid.h"
+#include "world.h"
 #include "nlohmann/json.hpp"
 
 using json = nlohmann::json;
 
-// Cấu trúc đại diện cho một người chơi
-struct Player
-{
-    std::string name;
-    int x, y;
-    int score = 0;
-    HQUIC stream = nullptr;
-};
-
-// Cấu trúc đại diện cho một vật phẩm
-struct Item
-{
-    uint32_t id;
-    int x, y;
-    bool active = true;
-};
-
-// Cấu trúc đại diện cho một viên đạn
-struct Bullet
-{
-    uint32_t id;
-    int x, y;
-    double dx, dy;
-    std::string shooter_name;
-    bool active = true;
-    double speed = 15.0;
-};
-
-class quicServer;
 class Gameplay
 {
 public:
     // Thêm io_context vào hàm tạo để sử dụng timer bất đồng bộ
-    Gameplay(quicServer &server, boost::asio::io_context &io);
+    Gameplay(Transport &transport, boost::asio::io_context &io, const GameplayConfig &config = {}, uint32_t roomId = 0);
     ~Gameplay();
-    // Xử lý các tin nhắn đến từ client
-    void handleMessage(HQUIC stream, const std::string &msg);
-    // Xử lý khi có stream mới được tạo
-    void handlePlayerConnected(HQUIC conn, HQUIC stream);
+    // Xử lý các tin nhắn đến từ client. Gọi được từ luồng mạng bất kỳ: tin nhắn chỉ
+    // được giải mã thành lệnh và đẩy vào hàng đợi, tick kế tiếp mới áp dụng.
+    void handleMessage(ConnectionId conn, std::string_view msg);
+    // Như trên với tin đã giải mã sẵn (RoomManager giải mã join để chọn phòng)
+    void handleJson(ConnectionId conn, const json &j);
     // Xử lý khi người chơi ngắt kết nối
-    void handlePlayerDisconnected(HQUIC stream);
+    void handlePlayerDisconnected(ConnectionId conn);
+
+    // Token nối lại trong tin join (chuỗi hex), 0 nếu không có hoặc sai dạng
+    static uint64_t resumeToken(const json &j);
+    // Token còn hiệu lực trong phòng này (gọi được từ luồng mạng): RoomManager chỉ cho
+    // join vượt sức chứa của phòng khi token thật sự giữ một người chơi ở đây
+    bool hasResumeToken(uint64_t token);
 
     // Bắt đầu và dừng vòng lặp game
     void startGameLoop();
     void stopGameLoop();
-    // Các hàm logic game
+
+    // Chạy đồng bộ đúng một tick (lệnh đầu vào, mô phỏng, broadcast, thống kê) mà không
+    // hẹn giờ; vòng lặp game gọi hàm này, benchmark gọi trực tiếp
+    void runTick();
+    World &world() { return world_; }
+
+    // Bản sao thống kê thời gian tick (an toàn khi gọi từ thread khác)
+    TickStats tickStats();
 
 private:
-    quicServer &quic_server_;
+    Transport &transport_;
+    GameplayConfig config_;
+    uint32_t roomId_;
+
+    // Luồng mạng đẩy lệnh vào, vòng lặp game lấy hết ở đầu mỗi tick
+    MpscQueue<InputCommand> inputs_;
+    std::atomic<uint64_t> droppedInputs_{0};
+    // Join/leave không vào được hàng đợi đầy: giữ theo thứ tự ở đây, tick kế tiếp áp dụng
+    // ngay sau các lệnh trong hàng đợi
+    std::vector<InputCommand> spilledInputs_;
+    std::vector<InputCommand> spillDrain_; // chỉ vòng lặp game
+    std::mutex spill_mutex_;
+    std::atomic<bool> hasSpilled_{false};
+    void enqueueInput(InputCommand &&cmd);
+    void applyInputs();
+
+    // Bù trễ khi bắn: số tick lùi lại theo tick client báo và RTT đo được,
+    // chặn bởi cửa sổ lagCompensationMs
+    static constexpr uint32_t kRewindToleranceTicks = 2;
+    uint8_t rewindTicks(const InputCommand &cmd, uint32_t tick) const;
+
+    // Cooldown bắn tính theo tick (làm tròn lên), 0 = không giới hạn
+    uint32_t shotCooldownTicks_;
 
-    std::map<HQUIC, Player> players_;
-    std::mutex players_mutex_;
+    // Thế giới game: chỉ vòng lặp game (executor của phòng) đọc ghi nên không cần khoá
+    World world_;
+    std::vector<uint32_t> hits_;
+    CandidateBlock candidates_;
 
-    std::vector<Item> items_;
-    std::mutex items_mutex_;
+    // Ghi lệnh đầu vào ra file để replay offline (tắt khi recordDir rỗng)
+    ReplayRecorder recorder_;
+    uint64_t recordStartNs_ = 0;
+    void openRecording();
 
-    std::vector<Bullet> bullets_;
-    std::mutex bullets_mutex_;
+    // Lưới thô (ô = bán kính tầm nhìn) cho lọc vùng quan tâm khi broadcast
+    SpatialGrid playerViewGrid_;
+    SpatialGrid itemViewGrid_;
+    SpatialGrid bulletViewGrid_;
+    std::vector<uint32_t> visible_;
+
+    // Trạng thái đồng bộ của từng client: lịch sử snapshot đã gửi, định dạng đã
+    // thương lượng khi join và độ ưu tiên tích luỹ của các thay đổi chưa gửi
+    struct ClientReplication
+    {
+        SnapshotHistory history;
+        WireEncoding encoding = WireEncoding::Json;
+        PriorityAccumulator priority;
+        uint64_t token = 0;         // token nối lại đã gửi trong welcome
+        uint32_t detachedUntil = 0; // mất kết nối: tick hết thời gian chờ (0 = đang kết nối)
+        uint32_t nextShotTick = 0;  // tick sớm nhất được bắn tiếp (cooldown)
+    };
+    std::unordered_map<EntityId, ClientReplication> clients_;
+
+    // Nối lại sau khi mất kết nối: token (dùng một lần) trỏ tới người chơi, người chơi mất
+    // kết nối nằm trong detached_ tới khi được nhận lại hoặc hết graceTicks_
+    uint32_t graceTicks_;
+    // tokens_ chỉ vòng lặp game ghi; khoá để luồng mạng tra được qua hasResumeToken
+    std::unordered_map<uint64_t, EntityId> tokens_;
+    std::mutex tokens_mutex_;
+    std::vector<EntityId> detached_;
+    std::random_device tokenSource_;
+    uint64_t issueToken(EntityId e);
+    void revokeToken(uint64_t token);
+    bool detachPlayer(const InputCommand &cmd, uint32_t tick);
+    bool resolveResume(InputCommand &cmd);
+    void expireDetached(uint32_t tick);
+    void recordInput(const InputCommand &cmd, uint32_t tick);
+
+    // Bộ nhớ tái sử dụng cho việc dựng và mã hoá snapshot
+    SnapshotMessage snapshot_;
+    std::vector<SnapshotMessage::LeaderboardEntry> leaderboard_;
+    std::string wireBuffer_;
 
-    // Các ID duy nhất
-    std::atomic<uint32_t> nextItemId_{1};
-    std::atomic<uint32_t> nextBulletId_{1};
-    std::chrono::steady_clock::time_point lastItemSpawn_;
     // Vòng lặp game bất đồng bộ
+    std::chrono::steady_clock::duration tickPeriod_;
     boost::asio::steady_timer gameLoopTimer_;
     std::atomic<bool> gameRunning_{false};
     void gameLoop(const boost::system::error_code &error);
-    void addPlayer(HQUIC stream, const std::string &name);
-    void removePlayer(HQUIC stream);
+    void scheduleNextTick(std::chrono::steady_clock::time_point now);
+
+    // Đo thời gian tick và xử lý quá hạn
+    TickStats stats_;
+    std::mutex stats_mutex_;
+    uint32_t broadcastDivisor_ = 1;
+    uint32_t healthyTicks_ = 0;
+    std::chrono::steady_clock::time_point lastStatsLog_;
+
     void broadcastGameState();
-    void spawnItem();
-    void createBullet(const std::string &shooterName, int x, int y, int dx, int dy);
-    void checkItemCollection();
-    void updateBullets();
-    void checkBulletCollisions();
-    void sendWelcomeMessage(HQUIC stream, const std::string &playerName);
+    void collectVisible(const SpatialGrid &grid, int x, int y, std::vector<uint32_t> &out, uint32_t total);
+    void buildFrame(int x, int y, ClientFrame &frame);
+    void buildSnapshot(const ClientFrame &frame, const ClientFrame *base);
+    void buildLeaderboard(std::vector<SnapshotMessage::LeaderboardEntry> &out) const;
+    void sendWelcomeMessage(ClientId client, const std::string &playerName, WireEncoding encoding, uint64_t token, bool resumed);
 };
 
 #endif // GAMEPLAY_H
\ No newline at end of file
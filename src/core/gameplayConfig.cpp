@@ -0,0 +1,61 @@
+#include "gameplayConfig.h"
+#include <algorithm>
+#include <fstream>
+#include <iostream>
+#include <nlohmann/json.hpp>
+
+bool GameplayConfig::LoadConfig(const std::string &path)
+{
+    std::ifstream file(path);
+    if (!file.is_open())
+    {
+        std::cerr << "Cannot open Gameplay config file: " << path << std::endl;
+        return false;
+    }
+
+    try
+    {
+        nlohmann::json j;
+        file >> j;
+        viewRadius = j.value("viewRadius", viewRadius);
+        leaderboardSize = j.value("leaderboardSize", leaderboardSize);
+        roomExecutors = j.value("roomExecutors", roomExecutors);
+        ioThreads = j.value("ioThreads", ioThreads);
+        maxPlayersPerRoom = j.value("maxPlayersPerRoom", maxPlayersPerRoom);
+        tickRate = std::max(1, j.value("tickRate", tickRate));
+        maxCatchUpTicks = std::max(0, j.value("maxCatchUpTicks", maxCatchUpTicks));
+        maxBroadcastDivisor = std::max(1, j.value("maxBroadcastDivisor", maxBroadcastDivisor));
+        snapshotBudgetBytes = std::max(0, j.value("snapshotBudgetBytes", snapshotBudgetBytes));
+        inputQueueCapacity = std::max(16, j.value("inputQueueCapacity", inputQueueCapacity));
+        lagCompensationMs = std::max(0, j.value("lagCompensationMs", lagCompensationMs));
+        reconnectGraceMs = std::max(0, j.value("reconnectGraceMs", reconnectGraceMs));
+        shotCooldownMs = std::max(0, j.value("shotCooldownMs", shotCooldownMs));
+        ingressMessagesPerSec = j.value("ingressMessagesPerSec", ingressMessagesPerSec);
+        ingressMessageBurst = j.value("ingressMessageBurst", ingressMessageBurst);
+        ingressBytesPerSec = j.value("ingressBytesPerSec", ingressBytesPerSec);
+        ingressByteBurst = j.value("ingressByteBurst", ingressByteBurst);
+        maxFrameBytes = std::max(256, j.value("maxFrameBytes", maxFrameBytes));
+        worldSeed = j.value("worldSeed", worldSeed);
+        recordDir = j.value("recordDir", recordDir);
+        logEvents = j.value("logEvents", logEvents);
+        statsLogIntervalSec = j.value("statsLogIntervalSec", statsLogIntervalSec);
+
+        std::string policy = j.value("overrunPolicy", std::string("catchup"));
+        if (policy == "skip")
+            overrunPolicy = OverrunPolicy::Skip;
+        else if (policy == "degrade")
+            overrunPolicy = OverrunPolicy::DegradeBroadcast;
+        else
+            overrunPolicy = OverrunPolicy::CatchUp;
+        std::cout << "Gameplay: viewRadius: " << viewRadius << " leaderboardSize: " << leaderboardSize
+                  << " roomExecutors: " << roomExecutors << " ioThreads: " << ioThreads << " maxPlayersPerRoom: " << maxPlayersPerRoom
+                  << " tickRate: " << tickRate << " overrunPolicy: " << policy << std::endl;
+    }
+    catch (std::exception &e)
+    {
+        std::cerr << "Gameplay config parse error: " << e.what() << std::endl;
+        return false;
+    }
+
+    return true;
+}
@@ -0,0 +1,88 @@
+#ifndef GAMEPLAY_CONFIG_H
+#define GAMEPLAY_CONFIG_H
+
+#include <cstdint>
+#include <string>
+
+// Cách xử lý khi một tick chạy quá hạn của tick kế tiếp
+enum class OverrunPolicy
+{
+    Skip,             // bỏ các tick đã lỡ, bám lại lịch
+    CatchUp,          // chạy bù liên tiếp, tối đa maxCatchUpTicks tick
+    DegradeBroadcast, // chạy bù có giới hạn và giảm tần suất broadcast
+};
+
+// Các tham số gameplay, đọc từ core/config.json (thiếu trường nào thì giữ mặc định)
+struct GameplayConfig
+{
+    // Bán kính tầm nhìn: mỗi client chỉ nhận thực thể trong bán kính này quanh
+    // người chơi của mình. <= 0 nghĩa là tắt lọc, gửi toàn bộ thế giới.
+    int viewRadius = 800;
+
+    // Số người chơi đứng đầu gửi kèm mỗi snapshot (phần toàn cục)
+    int leaderboardSize = 10;
+
+    // Số executor (mỗi executor một thread ghim vào một core) chạy các phòng.
+    // 0 = theo số core của máy.
+    int roomExecutors = 0;
+
+    // Số io thread của mạng (mỗi kết nối gắn cố định vào một thread theo ConnectionId).
+    // 0 = theo số core của máy.
+    int ioThreads = 0;
+
+    // Số người chơi tối đa trong một phòng trước khi ghép sang phòng mới
+    int maxPlayersPerRoom = 100;
+
+    // Số tick mỗi giây của vòng lặp game
+    int tickRate = 20;
+
+    // Chính sách khi tick quá hạn: "skip", "catchup" hoặc "degrade"
+    OverrunPolicy overrunPolicy = OverrunPolicy::CatchUp;
+    int maxCatchUpTicks = 3;
+    // Với "degrade": broadcast thưa nhất là mỗi N tick
+    int maxBroadcastDivisor = 4;
+
+    // Ngân sách byte snapshot mỗi client mỗi tick (ước lượng theo định dạng dây). Khi vượt,
+    // thực thể gần và lâu chưa gửi được ưu tiên, phần còn lại hoãn sang tick sau.
+    // 0 = không giới hạn.
+    int snapshotBudgetBytes = 8192;
+
+    // Sức chứa hàng đợi lệnh đầu vào của mỗi phòng (lệnh từ luồng mạng chờ tick kế tiếp)
+    int inputQueueCapacity = 4096;
+
+    // Bù trễ khi bắn: xét trúng đạn theo vị trí người chơi mà người bắn đã thấy,
+    // lùi tối đa chừng này mili giây (0 = tắt, xét theo vị trí hiện tại)
+    int lagCompensationMs = 200;
+
+    // Người chơi mất kết nối được giữ trong thế giới chừng này mili giây; client nối lại
+    // kèm token trong welcome thì nhận lại đúng người chơi đó (0 = xoá ngay khi ngắt)
+    int reconnectGraceMs = 10000;
+
+    // Khoảng cách tối thiểu giữa hai phát bắn của một người chơi (0 = không giới hạn)
+    int shotCooldownMs = 100;
+
+    // Kiểm soát đầu vào mỗi kết nối ở tầng mạng: tin vượt token bucket (số tin và số byte
+    // mỗi giây, kèm sức chứa burst) bị bỏ trước khi giải mã; <= 0 là không giới hạn
+    int ingressMessagesPerSec = 60;
+    int ingressMessageBurst = 120;
+    int ingressBytesPerSec = 16384;
+    int ingressByteBurst = 32768;
+    // Kích thước tối đa một tin client gửi (byte)
+    int maxFrameBytes = 4096;
+
+    // Seed cho bộ sinh ngẫu nhiên của mỗi phòng (0 = ngẫu nhiên mỗi lần chạy)
+    uint32_t worldSeed = 0;
+
+    // Thư mục ghi log lệnh đầu vào của mỗi phòng để replay offline (rỗng = tắt)
+    std::string recordDir;
+
+    // In log từng sự kiện (tin nhắn thô, nhặt vật phẩm, trúng đạn...); tắt khi tải cao
+    bool logEvents = true;
+
+    // Chu kỳ in thống kê tick ra log (giây, <= 0 để tắt)
+    int statsLogIntervalSec = 10;
+
+    bool LoadConfig(const std::string &path);
+};
+
+#endif // GAMEPLAY_CONFIG_H
@@ -0,0 +1,94 @@
+#ifndef MPSC_QUEUE_H
+#define MPSC_QUEUE_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <utility>
+
+// Hàng đợi vòng giới hạn, nhiều luồng đẩy - một luồng lấy, không khoá.
+// Mỗi ô có số thứ tự riêng (thuật toán của Dmitry Vyukov): producer giành vị trí
+// bằng CAS trên enqueuePos_, ghi dữ liệu rồi công bố ô bằng cách tăng sequence.
+// Consumer chỉ đọc ô đã công bố nên thứ tự lấy ra đúng bằng thứ tự giành vị trí.
+template <typename T>
+class MpscQueue
+{
+public:
+    // capacity được làm tròn lên lũy thừa của 2
+    explicit MpscQueue(size_t capacity)
+    {
+        size_t size = 2;
+        while (size < capacity)
+            size <<= 1;
+        mask_ = size - 1;
+        cells_ = std::make_unique<Cell[]>(size);
+        for (size_t i = 0; i < size; ++i)
+            cells_[i].sequence.store(i, std::memory_order_relaxed);
+    }
+
+    MpscQueue(const MpscQueue &) = delete;
+    MpscQueue &operator=(const MpscQueue &) = delete;
+
+    // Gọi từ bất kỳ luồng nào; trả về false nếu hàng đợi đầy
+    bool push(T &&value)
+    {
+        Cell *cell;
+        size_t pos = enqueuePos_.load(std::memory_order_relaxed);
+        for (;;)
+        {
+            cell = &cells_[pos & mask_];
+            const size_t seq = cell->sequence.load(std::memory_order_acquire);
+            const intptr_t diff = static_cast<intptr_t>(seq) - static_cast<intptr_t>(pos);
+            if (diff == 0)
+            {
+                if (enqueuePos_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+                    break;
+            }
+            else if (diff < 0)
+            {
+                return false;
+            }
+            else
+            {
+                pos = enqueuePos_.load(std::memory_order_relaxed);
+            }
+        }
+
+        cell->value = std::move(value);
+        cell->sequence.store(pos + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Chỉ gọi từ luồng consumer; trả về false nếu chưa có phần tử nào được công bố
+    bool pop(T &out)
+    {
+        Cell &cell = cells_[dequeuePos_ & mask_];
+        const size_t seq = cell.sequence.load(std::memory_order_acquire);
+        if (seq != dequeuePos_ + 1)
+            return false;
+
+        out = std::move(cell.value);
+        cell.sequence.store(dequeuePos_ + mask_ + 1, std::memory_order_release);
+        ++dequeuePos_;
+        return true;
+    }
+
+    size_t capacity() const { return mask_ + 1; }
+
+private:
+    struct Cell
+    {
+        std::atomic<size_t> sequence;
+        T value;
+    };
+
+    std::unique_ptr<Cell[]> cells_;
+    size_t mask_ = 0;
+
+    // Tách producer và consumer ra các cache line khác nhau
+    alignas(64) std::atomic<size_t> enqueuePos_{0};
+    alignas(64) size_t dequeuePos_ = 0;
+};
+
+#endif // MPSC_QUEUE_H
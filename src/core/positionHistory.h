@@ -0,0 +1,51 @@
+#ifndef POSITION_HISTORY_H
+#define POSITION_HISTORY_H
+
+#include <cstdint>
+#include <vector>
+#include "entityStore.h"
+
+// Vòng lưu vị trí người chơi ở các tick gần nhất cho bù trễ khi bắn. Mỗi tick chỉ
+// chép ba cột id/x/y của PlayerStore vào slot cũ nhất (tái dùng bộ nhớ, không cấp phát
+// khi số người chơi ổn định), nên chi phí ghi là vài memcpy.
+class PositionHistory
+{
+public:
+    struct Frame
+    {
+        uint32_t tick = 0;
+        bool valid = false;
+        std::vector<EntityId> id;
+        std::vector<int> x, y;
+    };
+
+    // depth = số tick giữ lại (tối thiểu 1)
+    explicit PositionHistory(uint32_t depth)
+        : frames_(depth > 0 ? depth : 1)
+    {
+    }
+
+    void record(uint32_t tick, const PlayerStore &players)
+    {
+        Frame &f = frames_[tick % frames_.size()];
+        f.tick = tick;
+        f.valid = true;
+        f.id.assign(players.id.begin(), players.id.end());
+        f.x.assign(players.x.begin(), players.x.end());
+        f.y.assign(players.y.begin(), players.y.end());
+    }
+
+    // Vị trí ở cuối tick `tick`; nullptr nếu tick đó đã bị ghi đè hoặc chưa ghi
+    const Frame *at(uint32_t tick) const
+    {
+        const Frame &f = frames_[tick % frames_.size()];
+        return (f.valid && f.tick == tick) ? &f : nullptr;
+    }
+
+    uint32_t depth() const { return static_cast<uint32_t>(frames_.size()); }
+
+private:
+    std::vector<Frame> frames_;
+};
+
+#endif // POSITION_HISTORY_H
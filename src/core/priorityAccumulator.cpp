@@ -0,0 +1,176 @@
+#include "priorityAccumulator.h"
+#include <algorithm>
+#include <cmath>
+
+namespace
+{
+    // Trọng số theo loại thực thể: vật phẩm đứng yên nên chậm một chút không sao
+    constexpr float kKindWeight[3] = {1.0f, 0.5f, 1.0f};
+    // Thực thể mới xuất hiện hoặc vừa biến mất quan trọng hơn một lần đổi vị trí
+    constexpr float kSpawnWeight = 2.0f;
+    // Người chơi của chính client luôn được gửi trước
+    constexpr float kSelfWeight = 1000.0f;
+
+    const ClientFrame kEmptyFrame;
+
+    // Ghép mốc và desired theo id: thực thể có thay đổi được chọn lấy trạng thái mới,
+    // thay đổi bị hoãn giữ nguyên trạng thái client đang có (hoặc vắng mặt)
+    template <typename State>
+    void mergeSelected(const std::vector<State> &base, const std::vector<State> &desired,
+                       const std::vector<uint8_t> &sendChanged, const std::vector<uint8_t> &sendRemoved,
+                       std::vector<State> &out)
+    {
+        size_t b = 0, d = 0;
+        while (b < base.size() || d < desired.size())
+        {
+            if (d == desired.size() || (b < base.size() && base[b].id < desired[d].id))
+            {
+                if (!sendRemoved[b])
+                    out.push_back(base[b]);
+                ++b;
+            }
+            else if (b == base.size() || desired[d].id < base[b].id)
+            {
+                if (sendChanged[d])
+                    out.push_back(desired[d]);
+                ++d;
+            }
+            else
+            {
+                out.push_back(sendChanged[d] ? desired[d] : base[b]);
+                ++b;
+                ++d;
+            }
+        }
+    }
+}
+
+PriorityAccumulator::Selection PriorityAccumulator::select(const ClientFrame *base, ClientFrame &frame, EntityId self,
+                                                           int viewerX, int viewerY, int falloff, size_t budgetBytes,
+                                                           const SnapshotCost &cost, const PlayerStore &players)
+{
+    const ClientFrame &desired = frame;
+    const ClientFrame &from = base ? *base : kEmptyFrame;
+    ++round_;
+    pending_.clear();
+
+    const float scale = static_cast<float>(std::max(1, falloff));
+    size_t total = 0;
+    auto add = [&](Kind kind, EntityId id, uint32_t index, int x, int y, bool spawn, bool removal, size_t bytes)
+    {
+        const float dist = std::hypot(static_cast<float>(x - viewerX), static_cast<float>(y - viewerY));
+        float weight = kKindWeight[kind] * scale / (scale + dist);
+        if (spawn)
+            weight *= kSpawnWeight;
+        if (kind == Player && id == self)
+            weight += kSelfWeight;
+
+        const uint64_t key = (static_cast<uint64_t>(id) << 2) | kind;
+        pending_.push_back({weight, static_cast<uint32_t>(bytes), key, index, kind, removal});
+        total += bytes;
+    };
+
+    diffStates(from.players, desired.players, [&](const PlayerState &st, bool created)
+               {
+                   size_t bytes = cost.player;
+                   if (created)
+                   {
+                       uint32_t i = players.indexOf(st.id);
+                       bytes += cost.created + (i != kNoIndex ? players.name[i].size() : 0);
+                   }
+                   add(Player, st.id, static_cast<uint32_t>(&st - desired.players.data()), st.x, st.y, created, false, bytes); },
+               [&](EntityId) {});
+    diffStates(from.items, desired.items, [&](const ItemState &st, bool created)
+               { add(Item, st.id, static_cast<uint32_t>(&st - desired.items.data()), st.x, st.y, created, false, cost.item); },
+               [&](EntityId) {});
+    diffStates(from.bullets, desired.bullets, [&](const BulletState &st, bool created)
+               { add(Bullet, st.id, static_cast<uint32_t>(&st - desired.bullets.data()), st.x, st.y, created, false,
+                     cost.bullet + (created ? cost.created : 0)); },
+               [&](EntityId) {});
+
+    // diffStates chỉ báo id khi xoá nên duyệt lại mốc để lấy vị trí và chỉ số
+    auto addRemovals = [&](Kind kind, const auto &baseStates, const auto &desiredStates)
+    {
+        size_t d = 0;
+        for (uint32_t b = 0; b < baseStates.size(); ++b)
+        {
+            while (d < desiredStates.size() && desiredStates[d].id < baseStates[b].id)
+                ++d;
+            if (d == desiredStates.size() || desiredStates[d].id != baseStates[b].id)
+                add(kind, baseStates[b].id, b, baseStates[b].x, baseStates[b].y, true, true, cost.removed);
+        }
+    };
+    if (base)
+    {
+        addRemovals(Player, from.players, desired.players);
+        addRemovals(Item, from.items, desired.items);
+        addRemovals(Bullet, from.bullets, desired.bullets);
+    }
+
+    // Mọi thay đổi đều vừa ngân sách: gửi hết, không còn gì tồn đọng
+    Selection sel;
+    if (total <= budgetBytes)
+    {
+        accumulated_.clear();
+        sel.sent = pending_.size();
+        sel.bytes = total;
+        return sel;
+    }
+
+    for (Pending &p : pending_)
+    {
+        Accumulated &acc = accumulated_[p.key];
+        acc.priority += p.priority;
+        acc.seen = round_;
+        p.priority = acc.priority;
+    }
+
+    // Thay đổi không còn chờ (đã giống mốc) thì bỏ phần tích luỹ
+    for (auto it = accumulated_.begin(); it != accumulated_.end();)
+    {
+        if (it->second.seen != round_)
+            it = accumulated_.erase(it);
+        else
+            ++it;
+    }
+
+    // Ưu tiên cao trước; cùng ưu tiên thì theo key để kết quả tất định
+    std::sort(pending_.begin(), pending_.end(), [](const Pending &a, const Pending &b)
+              { return a.priority != b.priority ? a.priority > b.priority : a.key < b.key; });
+
+    const size_t sizes[3][2] = {{desired.players.size(), from.players.size()},
+                                {desired.items.size(), from.items.size()},
+                                {desired.bullets.size(), from.bullets.size()}};
+    for (int k = 0; k < 3; ++k)
+    {
+        sendChanged_[k].assign(sizes[k][0], 0);
+        sendRemoved_[k].assign(sizes[k][1], 0);
+    }
+
+    // Lấy dần theo thứ tự ưu tiên, bỏ qua mục không vừa nhưng vẫn thử mục nhỏ hơn phía sau.
+    // Mục đầu tiên luôn được gửi để client không bao giờ đứng yên hoàn toàn.
+    for (const Pending &p : pending_)
+    {
+        if (sel.sent > 0 && sel.bytes + p.bytes > budgetBytes)
+        {
+            ++sel.deferred;
+            continue;
+        }
+        sel.bytes += p.bytes;
+        ++sel.sent;
+        (p.removal ? sendRemoved_ : sendChanged_)[p.kind][p.index] = 1;
+        accumulated_.erase(p.key);
+    }
+
+    // Chuyển trạng thái mong muốn ra bộ đệm riêng (đổi chỗ, không chép) rồi ghép lại vào frame
+    desired_.players.swap(frame.players);
+    desired_.items.swap(frame.items);
+    desired_.bullets.swap(frame.bullets);
+    frame.players.clear();
+    frame.items.clear();
+    frame.bullets.clear();
+    mergeSelected(from.players, desired_.players, sendChanged_[Player], sendRemoved_[Player], frame.players);
+    mergeSelected(from.items, desired_.items, sendChanged_[Item], sendRemoved_[Item], frame.items);
+    mergeSelected(from.bullets, desired_.bullets, sendChanged_[Bullet], sendRemoved_[Bullet], frame.bullets);
+    return sel;
+}
@@ -0,0 +1,72 @@
+#ifndef PRIORITY_ACCUMULATOR_H
+#define PRIORITY_ACCUMULATOR_H
+
+#include <cstddef>
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+#include "entityStore.h"
+#include "snapshot.h"
+#include "snapshotCodec.h"
+
+// Chọn những thay đổi được gửi cho một client khi snapshot vượt ngân sách byte mỗi tick.
+// Mỗi thay đổi đang chờ (thực thể mới, đổi trạng thái hoặc bị xoá so với mốc client
+// đã ack) cộng dồn độ ưu tiên theo loại thực thể và khoảng cách tới người xem; thay đổi
+// được chọn thì về 0, thay đổi bị hoãn giữ phần đã tích luỹ nên tick sau được ưu tiên
+// hơn. Nhờ vậy thực thể xa vẫn được cập nhật, chỉ thưa hơn, và không thực thể nào bị
+// bỏ đói.
+class PriorityAccumulator
+{
+public:
+    struct Selection
+    {
+        size_t sent = 0;     // số thay đổi được gửi
+        size_t deferred = 0; // số thay đổi hoãn sang tick sau
+        size_t bytes = 0;    // số byte ước lượng của phần thực thể
+    };
+
+    // frame vào là trạng thái client nên thấy, ra là trạng thái client sẽ có sau snapshot
+    // này: mốc (base, nullptr = client chưa có gì) cộng các thay đổi ưu tiên nhất vừa
+    // budgetBytes. Khi đó diff(base, frame) chính là phần được gửi. self là người chơi
+    // của client, luôn ưu tiên. Nếu mọi thay đổi đều vừa thì frame giữ nguyên.
+    Selection select(const ClientFrame *base, ClientFrame &frame, EntityId self,
+                     int viewerX, int viewerY, int falloff, size_t budgetBytes,
+                     const SnapshotCost &cost, const PlayerStore &players);
+
+private:
+    enum Kind : uint8_t
+    {
+        Player,
+        Item,
+        Bullet,
+    };
+
+    struct Pending
+    {
+        float priority;
+        uint32_t bytes;
+        uint64_t key;   // (id << 2) | kind: id chỉ duy nhất trong một loại
+        uint32_t index; // chỉ số trong desired (thay đổi) hoặc trong base (xoá)
+        Kind kind;
+        bool removal;
+    };
+
+    struct Accumulated
+    {
+        float priority = 0.0f;
+        uint32_t seen = 0; // lần select gần nhất còn thay đổi đang chờ
+    };
+
+    std::unordered_map<uint64_t, Accumulated> accumulated_;
+    std::vector<Pending> pending_;
+    uint32_t round_ = 0;
+
+    // Trạng thái mong muốn, chuyển khỏi frame khi phải ghép với mốc
+    ClientFrame desired_;
+
+    // Đánh dấu đã chọn theo chỉ số trong desired/base của từng loại
+    std::vector<uint8_t> sendChanged_[3];
+    std::vector<uint8_t> sendRemoved_[3];
+};
+
+#endif // PRIORITY_ACCUMULATOR_H
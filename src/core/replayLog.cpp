@@ -0,0 +1,345 @@
+#include "replayLog.h"
+#include <cstring>
+#include <iostream>
+#include <sstream>
+
+// Định dạng file ghi (.rec):
+//
+//   "GREC" u8 version = 4
+//   varint seed, varint tickRate, varint roomId, varint startUnixMs,
+//   [từ version 4] varint lagCompensationMs
+//   bản ghi, mỗi bản ghi bắt đầu bằng u8 kind:
+//     1 input:    varint tick, varint timeNs, u8 type, varint client,
+//                 [move/shoot] svarint x, svarint y,
+//                 [shoot] f64 dx, f64 dy (nguyên bit, để replay khớp tuyệt đối),
+//                 [shoot, từ version 2] varint rewind,
+//                 [join] u8 encoding, varint len + tên
+//                 [resume, từ version 3] varint client cũ
+//     2 checksum: varint tick, u64 checksum
+//     3 end:      varint tick
+//
+// varint là LEB128 không dấu, svarint là zigzag + LEB128, số cố định là little-endian.
+// Một lệnh move chỉ tốn khoảng 10 byte.
+
+namespace
+{
+    constexpr char kMagic[4] = {'G', 'R', 'E', 'C'};
+    constexpr uint8_t kVersion = 4;
+    constexpr uint8_t kMinVersion = 1; // version 1 chưa có rewind (coi như 0)
+    constexpr size_t kFlushThreshold = 64 * 1024;
+
+    void putVarint(std::string &out, uint64_t v)
+    {
+        while (v >= 0x80)
+        {
+            out.push_back(static_cast<char>((v & 0x7F) | 0x80));
+            v >>= 7;
+        }
+        out.push_back(static_cast<char>(v));
+    }
+
+    void putSvarint(std::string &out, int64_t v)
+    {
+        putVarint(out, (static_cast<uint64_t>(v) << 1) ^ static_cast<uint64_t>(v >> 63));
+    }
+
+    void putU64(std::string &out, uint64_t v)
+    {
+        for (int i = 0; i < 8; ++i)
+            out.push_back(static_cast<char>((v >> (i * 8)) & 0xFF));
+    }
+
+    void putF64(std::string &out, double v)
+    {
+        uint64_t bits;
+        std::memcpy(&bits, &v, sizeof(bits));
+        putU64(out, bits);
+    }
+
+    class ByteReader
+    {
+    public:
+        ByteReader(const std::string &data, size_t &pos) : data_(data), pos_(pos) {}
+
+        bool u8(uint8_t &v)
+        {
+            if (pos_ >= data_.size())
+                return false;
+            v = static_cast<uint8_t>(data_[pos_++]);
+            return true;
+        }
+
+        bool varint(uint64_t &v)
+        {
+            v = 0;
+            for (int shift = 0; shift < 64; shift += 7)
+            {
+                uint8_t b;
+                if (!u8(b))
+                    return false;
+                v |= static_cast<uint64_t>(b & 0x7F) << shift;
+                if (!(b & 0x80))
+                    return true;
+            }
+            return false;
+        }
+
+        bool svarint(int64_t &v)
+        {
+            uint64_t u;
+            if (!varint(u))
+                return false;
+            v = static_cast<int64_t>(u >> 1) ^ -static_cast<int64_t>(u & 1);
+            return true;
+        }
+
+        bool u64(uint64_t &v)
+        {
+            if (data_.size() - pos_ < 8)
+                return false;
+            v = 0;
+            for (int i = 0; i < 8; ++i)
+                v |= static_cast<uint64_t>(static_cast<uint8_t>(data_[pos_ + i])) << (i * 8);
+            pos_ += 8;
+            return true;
+        }
+
+        bool f64(double &v)
+        {
+            uint64_t bits;
+            if (!u64(bits))
+                return false;
+            std::memcpy(&v, &bits, sizeof(v));
+            return true;
+        }
+
+        bool string(std::string &s)
+        {
+            uint64_t len;
+            if (!varint(len) || data_.size() - pos_ < len)
+                return false;
+            s.assign(data_, pos_, len);
+            pos_ += len;
+            return true;
+        }
+
+    private:
+        const std::string &data_;
+        size_t &pos_;
+    };
+}
+
+ReplayRecorder::~ReplayRecorder()
+{
+    flush();
+}
+
+bool ReplayRecorder::open(const std::string &path, const ReplayHeader &header)
+{
+    file_.open(path, std::ios::binary | std::ios::trunc);
+    if (!file_.is_open())
+    {
+        std::cerr << "[Replay] Cannot open record file: " << path << std::endl;
+        return false;
+    }
+
+    buffer_.clear();
+    buffer_.append(kMagic, sizeof(kMagic));
+    buffer_.push_back(static_cast<char>(kVersion));
+    putVarint(buffer_, header.seed);
+    putVarint(buffer_, header.tickRate);
+    putVarint(buffer_, header.roomId);
+    putVarint(buffer_, header.startUnixMs);
+    putVarint(buffer_, header.lagCompensationMs);
+    flush();
+    return true;
+}
+
+void ReplayRecorder::recordInput(uint32_t tick, uint64_t timeNs, const InputCommand &cmd)
+{
+    if (!file_.is_open())
+        return;
+
+    buffer_.push_back(static_cast<char>(ReplayRecordKind::Input));
+    putVarint(buffer_, tick);
+    putVarint(buffer_, timeNs);
+    buffer_.push_back(static_cast<char>(cmd.type));
+    putVarint(buffer_, cmd.client);
+    if (cmd.type == InputType::Move || cmd.type == InputType::Shoot)
+    {
+        putSvarint(buffer_, cmd.x);
+        putSvarint(buffer_, cmd.y);
+    }
+    if (cmd.type == InputType::Shoot)
+    {
+        putF64(buffer_, cmd.dx);
+        putF64(buffer_, cmd.dy);
+        putVarint(buffer_, cmd.rewind);
+    }
+    if (cmd.type == InputType::Join)
+    {
+        buffer_.push_back(static_cast<char>(cmd.encoding));
+        putVarint(buffer_, cmd.name.size());
+        buffer_.append(cmd.name);
+    }
+    if (cmd.type == InputType::Resume)
+        putVarint(buffer_, cmd.previous);
+
+    if (buffer_.size() >= kFlushThreshold)
+        flush();
+}
+
+void ReplayRecorder::recordChecksum(uint32_t tick, uint64_t checksum)
+{
+    if (!file_.is_open())
+        return;
+
+    buffer_.push_back(static_cast<char>(ReplayRecordKind::Checksum));
+    putVarint(buffer_, tick);
+    putU64(buffer_, checksum);
+    // Checksum ghi khoảng mỗi giây: đẩy xuống file luôn để crash không mất nhiều
+    flush();
+}
+
+void ReplayRecorder::close(uint32_t finalTick)
+{
+    if (!file_.is_open())
+        return;
+
+    buffer_.push_back(static_cast<char>(ReplayRecordKind::End));
+    putVarint(buffer_, finalTick);
+    flush();
+    file_.close();
+}
+
+void ReplayRecorder::flush()
+{
+    if (!file_.is_open() || buffer_.empty())
+        return;
+    file_.write(buffer_.data(), static_cast<std::streamsize>(buffer_.size()));
+    file_.flush();
+    buffer_.clear();
+}
+
+bool ReplayReader::open(const std::string &path)
+{
+    std::ifstream file(path, std::ios::binary);
+    if (!file.is_open())
+    {
+        error_ = "cannot open " + path;
+        return false;
+    }
+    std::ostringstream ss;
+    ss << file.rdbuf();
+    data_ = ss.str();
+    pos_ = 0;
+
+    if (data_.size() < sizeof(kMagic) + 1 || data_.compare(0, sizeof(kMagic), kMagic, sizeof(kMagic)) != 0)
+    {
+        error_ = "not a replay file";
+        return false;
+    }
+    pos_ = sizeof(kMagic);
+
+    ByteReader r(data_, pos_);
+    uint64_t seed, tickRate, roomId, startUnixMs;
+    if (!r.u8(version_) || version_ < kMinVersion || version_ > kVersion)
+    {
+        error_ = "unsupported replay version";
+        return false;
+    }
+    if (!r.varint(seed) || !r.varint(tickRate) || !r.varint(roomId) || !r.varint(startUnixMs))
+    {
+        error_ = "truncated header";
+        return false;
+    }
+    header_.seed = static_cast<uint32_t>(seed);
+    header_.tickRate = static_cast<uint32_t>(tickRate);
+    header_.roomId = static_cast<uint32_t>(roomId);
+    header_.startUnixMs = startUnixMs;
+    header_.lagCompensationMs = ReplayHeader{}.lagCompensationMs;
+    if (version_ >= 4)
+    {
+        uint64_t lagCompensationMs = 0;
+        if (!r.varint(lagCompensationMs))
+        {
+            error_ = "truncated header";
+            return false;
+        }
+        header_.lagCompensationMs = static_cast<uint32_t>(lagCompensationMs);
+    }
+    return true;
+}
+
+bool ReplayReader::next(ReplayRecord &record)
+{
+    if (pos_ >= data_.size())
+        return false;
+
+    ByteReader r(data_, pos_);
+    uint8_t kind = 0;
+    uint64_t tick = 0;
+    if (!r.u8(kind) || !r.varint(tick))
+    {
+        error_ = "truncated record";
+        return false;
+    }
+    record.kind = static_cast<ReplayRecordKind>(kind);
+    record.tick = static_cast<uint32_t>(tick);
+
+    bool ok = true;
+    switch (record.kind)
+    {
+    case ReplayRecordKind::Input:
+    {
+        InputCommand &cmd = record.input;
+        cmd = InputCommand{};
+        uint8_t type = 0;
+        uint64_t client = 0;
+        // Biến tạm khởi tạo 0: bản ghi cụt không để lại giá trị rác trong lệnh
+        ok = r.varint(record.timeNs) && r.u8(type) && r.varint(client);
+        cmd.type = static_cast<InputType>(type);
+        cmd.client = client;
+        if (ok && (cmd.type == InputType::Move || cmd.type == InputType::Shoot))
+        {
+            int64_t x = 0, y = 0;
+            ok = r.svarint(x) && r.svarint(y);
+            cmd.x = static_cast<int>(x);
+            cmd.y = static_cast<int>(y);
+        }
+        if (ok && cmd.type == InputType::Shoot)
+            ok = r.f64(cmd.dx) && r.f64(cmd.dy);
+        if (ok && cmd.type == InputType::Shoot && version_ >= 2)
+        {
+            uint64_t rewind = 0;
+            ok = r.varint(rewind) && rewind <= UINT8_MAX;
+            cmd.rewind = static_cast<uint8_t>(rewind);
+        }
+        if (ok && cmd.type == InputType::Join)
+        {
+            uint8_t encoding = 0;
+            ok = r.u8(encoding) && r.string(cmd.name);
+            cmd.encoding = static_cast<WireEncoding>(encoding);
+        }
+        if (ok && cmd.type == InputType::Resume)
+        {
+            uint64_t previous = 0;
+            ok = r.varint(previous);
+            cmd.previous = previous;
+        }
+        break;
+    }
+    case ReplayRecordKind::Checksum:
+        ok = r.u64(record.checksum);
+        break;
+    case ReplayRecordKind::End:
+        break;
+    default:
+        error_ = "unknown record kind";
+        return false;
+    }
+
+    if (!ok)
+        error_ = "truncated record";
+    return ok;
+}
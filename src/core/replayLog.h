@@ -0,0 +1,78 @@
+#ifndef REPLAY_LOG_H
+#define REPLAY_LOG_H
+
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include "world.h"
+
+// Thông tin đầu file ghi: đủ để dựng lại World giống hệt lúc ghi
+struct ReplayHeader
+{
+    uint32_t seed = 0;
+    uint32_t tickRate = 20;
+    uint32_t roomId = 0;
+    uint64_t startUnixMs = 0;
+    // Cửa sổ bù trễ lúc ghi: quyết định độ sâu lịch sử vị trí và mức rewind tối đa
+    // của World (file trước version 4 không có, coi như mặc định 200 ms)
+    uint32_t lagCompensationMs = 200;
+};
+
+enum class ReplayRecordKind : uint8_t
+{
+    Input = 1,    // lệnh áp dụng ngay trước tick `tick`
+    Checksum = 2, // World::checksum() sau tick `tick`
+    End = 3,      // trận kết thúc ở tick `tick`
+};
+
+struct ReplayRecord
+{
+    ReplayRecordKind kind = ReplayRecordKind::End;
+    uint32_t tick = 0;
+    uint64_t timeNs = 0; // thời điểm nhận lệnh, tính từ lúc bắt đầu ghi
+    InputCommand input;
+    uint64_t checksum = 0;
+};
+
+// Ghi log nhị phân gọn (xem replayLog.cpp) các lệnh đã áp dụng vào World.
+// Chỉ vòng lặp game của phòng gọi nên không cần khoá; dữ liệu gom trong bộ nhớ
+// và đẩy xuống file theo khối.
+class ReplayRecorder
+{
+public:
+    ~ReplayRecorder();
+
+    bool open(const std::string &path, const ReplayHeader &header);
+    bool isOpen() const { return file_.is_open(); }
+
+    void recordInput(uint32_t tick, uint64_t timeNs, const InputCommand &cmd);
+    void recordChecksum(uint32_t tick, uint64_t checksum);
+    void close(uint32_t finalTick);
+
+private:
+    void flush();
+
+    std::ofstream file_;
+    std::string buffer_;
+};
+
+// Đọc lần lượt các bản ghi của một file log
+class ReplayReader
+{
+public:
+    bool open(const std::string &path);
+    const ReplayHeader &header() const { return header_; }
+
+    // false khi hết file hoặc file hỏng (xem error())
+    bool next(ReplayRecord &record);
+    const std::string &error() const { return error_; }
+
+private:
+    std::string data_;
+    size_t pos_ = 0;
+    uint8_t version_ = 0;
+    ReplayHeader header_;
+    std::string error_;
+};
+
+#endif // REPLAY_LOG_H
@@ -0,0 +1,167 @@
+#include "roomManager.h"
+#include <iostream>
+#include <thread>
+
+RoomManager::RoomManager(Transport &transport, const GameplayConfig &config)
+    : transport_(transport), config_(config)
+{
+    size_t count = config_.roomExecutors > 0 ? static_cast<size_t>(config_.roomExecutors)
+                                             : std::max(1u, std::thread::hardware_concurrency());
+    for (size_t i = 0; i < count; ++i)
+        executors_.push_back(std::make_unique<AsioService>());
+}
+
+RoomManager::~RoomManager()
+{
+    stop();
+}
+
+void RoomManager::start()
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (running_)
+        return;
+    running_ = true;
+
+    const unsigned cores = std::max(1u, std::thread::hardware_concurrency());
+    for (size_t i = 0; i < executors_.size(); ++i)
+        executors_[i]->start(static_cast<int>(i % cores));
+    std::cout << "[RoomManager] Started " << executors_.size() << " executors\n";
+}
+
+void RoomManager::stop()
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!running_)
+        return;
+    running_ = false;
+
+    // Dừng thread trước, sau đó mới huỷ timer của các phòng từ thread này
+    for (auto &executor : executors_)
+        executor->stop();
+    for (auto &room : rooms_)
+        room->game->stopGameLoop();
+    for (ConnectionShard &shard : connections_)
+    {
+        std::lock_guard<std::mutex> shardLock(shard.mutex);
+        shard.rooms.clear();
+    }
+}
+
+void RoomManager::handleMessage(ConnectionId conn, std::string_view msg)
+{
+    if (!running_.load(std::memory_order_acquire))
+        return;
+
+    ConnectionShard &shard = shardOf(conn);
+    Room *room = nullptr;
+    {
+        std::lock_guard<std::mutex> shardLock(shard.mutex);
+        auto it = shard.rooms.find(conn);
+        if (it != shard.rooms.end())
+            room = it->second;
+    }
+    if (room)
+    {
+        // Gameplay chỉ giải mã và xếp lệnh vào hàng đợi, gọi thẳng từ luồng mạng
+        room->game->handleMessage(conn, msg);
+        return;
+    }
+
+    // Kết nối chưa vào phòng nào: chỉ tin "join" mới được định tuyến. Giải mã ngoài khoá
+    // và đưa luôn bản đã giải mã cho Gameplay.
+    auto j = json::parse(msg, nullptr, false);
+    if (j.is_discarded() || !j.is_object())
+        return;
+    auto action = j.find("action");
+    if (action == j.end() || *action != "join")
+        return;
+    auto requested = j.find("room");
+    const int64_t requestedRoom = requested != j.end() && requested->is_number_integer() ? requested->get<int64_t>() : -1;
+    const uint64_t token = Gameplay::resumeToken(j);
+
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (!running_.load(std::memory_order_relaxed))
+            return;
+        room = findRoomForJoin(requestedRoom, token);
+        room->players++;
+    }
+    {
+        // Tin của một kết nối được xử lý tuần tự (io của kết nối) nên không có join thứ
+        // hai của cùng kết nối chen vào giữa lúc tra và lúc ghi
+        std::lock_guard<std::mutex> shardLock(shard.mutex);
+        shard.rooms.emplace(conn, room);
+    }
+    std::cout << "[RoomManager] Connection " << conn << " -> room " << room->id << "\n";
+
+    room->game->handleJson(conn, j);
+}
+
+void RoomManager::handlePlayerConnected(ConnectionId conn)
+{
+    // Người chơi chỉ được gán phòng khi gửi "join"
+    if (config_.logEvents)
+        std::cout << "[RoomManager] Player connected: " << conn << "\n";
+}
+
+void RoomManager::handlePlayerDisconnected(ConnectionId conn)
+{
+    Room *room = nullptr;
+    {
+        ConnectionShard &shard = shardOf(conn);
+        std::lock_guard<std::mutex> shardLock(shard.mutex);
+        auto it = shard.rooms.find(conn);
+        if (it == shard.rooms.end())
+            return;
+        room = it->second;
+        shard.rooms.erase(it);
+    }
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        room->players--;
+    }
+
+    room->game->handlePlayerDisconnected(conn);
+}
+
+RoomManager::Room *RoomManager::findRoomForJoin(int64_t requestedRoom, uint64_t token)
+{
+    const size_t capacity = static_cast<size_t>(std::max(1, config_.maxPlayersPerRoom));
+
+    // Client xin vào một phòng cụ thể (ví dụ chơi cùng bạn bè). Client nối lại với token
+    // phòng đó đã cấp luôn về phòng cũ: người chơi của nó vẫn còn trong phòng dù chỗ đã
+    // được tính là trống. Token sai hoặc của phòng khác thì xét sức chứa như join thường.
+    if (requestedRoom >= 0 && static_cast<size_t>(requestedRoom) < rooms_.size())
+    {
+        Room *room = rooms_[requestedRoom].get();
+        if (room->players < capacity || room->game->hasResumeToken(token))
+            return room;
+    }
+
+    // Ghép vào phòng đầu tiên còn chỗ, hết chỗ thì mở phòng mới
+    for (auto &room : rooms_)
+    {
+        if (room->players < capacity)
+            return room.get();
+    }
+    return createRoom();
+}
+
+RoomManager::Room *RoomManager::createRoom()
+{
+    auto room = std::make_unique<Room>();
+    room->id = static_cast<uint32_t>(rooms_.size());
+    room->executor = room->id % executors_.size();
+
+    boost::asio::io_context &io = executors_[room->executor]->getContext();
+    room->game = std::make_unique<Gameplay>(transport_, io, config_, room->id);
+
+    Gameplay *game = room->game.get();
+    boost::asio::post(io, [game]()
+                      { game->startGameLoop(); });
+
+    std::cout << "[RoomManager] Created room " << room->id << " on executor " << room->executor << "\n";
+    rooms_.push_back(std::move(room));
+    return rooms_.back().get();
+}
@@ -0,0 +1,71 @@
+#ifndef ROOM_MANAGER_H
+#define ROOM_MANAGER_H
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+#include "../AsioService/AsioService.h"
+#include "../transport/transport.h"
+#include "gameplay.h"
+#include "gameplayConfig.h"
+
+// Quản lý nhiều phòng chơi (mỗi phòng một Gameplay độc lập). Mỗi phòng được ghim vào
+// một trong N executor (một io_context + một thread ghim core), nên thêm core là thêm
+// sức chứa. Các phòng không chia sẻ trạng thái: tin nhắn của client đi vào hàng đợi
+// lệnh của phòng và chỉ executor của phòng đó chạm vào thế giới game.
+class RoomManager
+{
+public:
+    RoomManager(Transport &transport, const GameplayConfig &config);
+    ~RoomManager();
+
+    void start();
+    void stop();
+
+    // Định tuyến tin nhắn tới phòng của kết nối; tin "join" đầu tiên chọn phòng. Gọi từ
+    // nhiều luồng mạng: tra phòng chỉ khoá một ngăn của bảng kết nối, khoá chung chỉ dùng
+    // khi chọn phòng cho join (tin join được giải mã một lần, ngoài khoá).
+    void handleMessage(ConnectionId conn, std::string_view msg);
+    void handlePlayerConnected(ConnectionId conn);
+    void handlePlayerDisconnected(ConnectionId conn);
+
+private:
+    struct Room
+    {
+        uint32_t id;
+        size_t executor;
+        std::unique_ptr<Gameplay> game;
+        size_t players = 0;
+    };
+
+    // Bảng kết nối -> phòng chia ngăn theo ConnectionId, mỗi ngăn một khoá
+    struct ConnectionShard
+    {
+        std::mutex mutex;
+        std::unordered_map<ConnectionId, Room *> rooms;
+    };
+    static constexpr size_t kConnectionShards = 64;
+    ConnectionShard &shardOf(ConnectionId conn) { return connections_[conn % kConnectionShards]; }
+
+    Room *findRoomForJoin(int64_t requestedRoom, uint64_t token);
+    Room *createRoom();
+
+    Transport &transport_;
+    GameplayConfig config_;
+
+    // executors_ khai báo trước rooms_ để các phòng (timer) huỷ trước io_context
+    std::vector<std::unique_ptr<AsioService>> executors_;
+    std::vector<std::unique_ptr<Room>> rooms_;
+    std::array<ConnectionShard, kConnectionShards> connections_;
+    // Khoá chung: danh sách phòng, số người của phòng, start/stop
+    std::mutex mutex_;
+    std::atomic<bool> running_{false};
+};
+
+#endif // ROOM_MANAGER_H
@@ -0,0 +1,118 @@
+#ifndef SNAPSHOT_H
+#define SNAPSHOT_H
+
+#include <array>
+#include <cstdint>
+#include <vector>
+#include "entityStore.h"
+
+// Trạng thái gọn của từng loại thực thể tại một tick, dùng để so sánh giữa các tick
+struct PlayerState
+{
+    EntityId id;
+    int x, y;
+    int score;
+    bool operator==(const PlayerState &) const = default;
+};
+
+struct ItemState
+{
+    EntityId id;
+    int x, y;
+    bool operator==(const ItemState &) const = default;
+};
+
+struct BulletState
+{
+    EntityId id;
+    int x, y;
+    double dx, dy;
+    EntityId shooter;
+    bool operator==(const BulletState &) const = default;
+};
+
+// Những gì đã gửi cho một client ở một tick (mỗi mảng sắp xếp theo id)
+struct ClientFrame
+{
+    uint32_t tick = 0;
+    bool valid = false;
+    std::vector<PlayerState> players;
+    std::vector<ItemState> items;
+    std::vector<BulletState> bullets;
+};
+
+// Vòng các frame đã gửi gần nhất của một client. Client ack tick đã áp dụng,
+// server dùng frame đó làm mốc để chỉ gửi phần thay đổi.
+class SnapshotHistory
+{
+public:
+    static constexpr uint32_t kSize = 32;
+
+    // Lấy slot cho tick mới (tái sử dụng bộ nhớ của frame cũ ở cùng slot)
+    ClientFrame &beginFrame(uint32_t tick)
+    {
+        ClientFrame &f = frames_[tick % kSize];
+        f.tick = tick;
+        f.valid = true;
+        f.players.clear();
+        f.items.clear();
+        f.bullets.clear();
+        return f;
+    }
+
+    // Ghi nhận ack; chỉ tiến lên, bỏ qua ack cũ hoặc đến sai thứ tự
+    void acknowledge(uint32_t tick)
+    {
+        if (!hasAck_ || tick > acked_)
+        {
+            acked_ = tick;
+            hasAck_ = true;
+        }
+    }
+
+    // Frame mốc cho tick hiện tại; nullptr nếu chưa ack hoặc mốc đã quá cũ
+    // (đã bị ghi đè trong vòng) -> phải gửi snapshot đầy đủ
+    const ClientFrame *baseline(uint32_t currentTick) const
+    {
+        if (!hasAck_ || acked_ >= currentTick || currentTick - acked_ >= kSize)
+            return nullptr;
+        const ClientFrame &f = frames_[acked_ % kSize];
+        return (f.valid && f.tick == acked_) ? &f : nullptr;
+    }
+
+private:
+    std::array<ClientFrame, kSize> frames_;
+    uint32_t acked_ = 0;
+    bool hasAck_ = false;
+};
+
+// So sánh hai mảng đã sắp xếp theo id: gọi onChanged(state, created) cho thực thể
+// mới hoặc thay đổi và onRemoved(id) cho thực thể không còn trong current
+template <typename State, typename OnChanged, typename OnRemoved>
+void diffStates(const std::vector<State> &baseline, const std::vector<State> &current,
+                OnChanged &&onChanged, OnRemoved &&onRemoved)
+{
+    size_t b = 0, c = 0;
+    while (b < baseline.size() || c < current.size())
+    {
+        if (c == current.size() || (b < baseline.size() && baseline[b].id < current[c].id))
+        {
+            onRemoved(baseline[b].id);
+            ++b;
+        }
+        else if (b == baseline.size() || current[c].id < baseline[b].id)
+        {
+            onChanged(current[c], true);
+            ++c;
+        }
+        else
+        {
+            if (!(baseline[b] == current[c]))
+                onChanged(current[c], false);
+            ++b;
+            ++c;
+        }
+    }
+}
+
+#endif // SNAPSHOT_H
@@ -0,0 +1,206 @@
+#include "snapshotCodec.h"
+#include <cmath>
+#include <nlohmann/json.hpp>
+#include "../message/frame.h"
+
+using json = nlohmann::json;
+
+// Định dạng nhị phân bin1 (payload bên trong khung của message/frame.h):
+//
+//   u8      type = 0x01 (snapshot)
+//   u8      version = 1
+//   varint  tick
+//   varint  baseline            0 = snapshot đầy đủ
+//   varint  playerCount
+//   varint  n, n x player:      varint id, u8 flags (bit0 = mới), svarint x, svarint y,
+//                               svarint score, [mới] varint len + tên UTF-8
+//   varint  n, n x item:        varint id, svarint x, svarint y
+//   varint  n, n x bullet:      varint id, u8 flags, svarint x, svarint y,
+//                               [mới] svarint dx*1024, svarint dy*1024, varint shooter id
+//   [baseline != 0] 3 x (varint n, n x varint id)   id bị xoá: players, items, bullets
+//   varint  n, n x leaderboard: varint id, svarint score, varint len + tên
+//
+// varint là LEB128 không dấu, svarint là zigzag + LEB128. Toạ độ là số nguyên đơn vị
+// thế giới nên trong bản đồ 0..2000 chỉ tốn 1-2 byte; hướng đạn lượng tử 1/1024.
+
+namespace
+{
+    constexpr double kDirectionScale = 1024.0;
+
+    class ByteWriter
+    {
+    public:
+        explicit ByteWriter(std::string &out) : out_(out) {}
+
+        void u8(uint8_t v) { out_.push_back(static_cast<char>(v)); }
+
+        void varint(uint64_t v)
+        {
+            while (v >= 0x80)
+            {
+                out_.push_back(static_cast<char>((v & 0x7F) | 0x80));
+                v >>= 7;
+            }
+            out_.push_back(static_cast<char>(v));
+        }
+
+        void svarint(int64_t v)
+        {
+            varint((static_cast<uint64_t>(v) << 1) ^ static_cast<uint64_t>(v >> 63));
+        }
+
+        void string(const std::string &s)
+        {
+            varint(s.size());
+            out_.append(s);
+        }
+
+    private:
+        std::string &out_;
+    };
+
+    const std::string &nameOf(const PlayerStore &players, EntityId id)
+    {
+        static const std::string empty;
+        uint32_t i = players.indexOf(id);
+        return i != kNoIndex ? players.name[i] : empty;
+    }
+}
+
+const SnapshotCost &snapshotCost(WireEncoding encoding)
+{
+    // Đo trên snapshot thật: toạ độ 0..2000, id vài chục nghìn, tên khoảng 10 ký tự
+    static constexpr SnapshotCost kJson{120, 44, 31, 31, 58, 6, 24};
+    static constexpr SnapshotCost kBinary{24, 9, 7, 7, 8, 3, 5};
+    return encoding == WireEncoding::Binary ? kBinary : kJson;
+}
+
+void SnapshotMessage::clear()
+{
+    tick = 0;
+    baseline = 0;
+    playerCount = 0;
+    players.clear();
+    items.clear();
+    bullets.clear();
+    removedPlayers.clear();
+    removedItems.clear();
+    removedBullets.clear();
+    leaderboard.clear();
+}
+
+void encodeSnapshotJson(const SnapshotMessage &msg, const PlayerStore &players, std::string &out)
+{
+    json state_json = json::object();
+    state_json["tick"] = msg.tick;
+
+    state_json["players"] = json::array();
+    for (const auto &e : msg.players)
+    {
+        json j = {{"id", e.state.id}, {"x", e.state.x}, {"y", e.state.y}, {"score", e.state.score}};
+        // Tên không đổi nên chỉ gửi khi client thấy người chơi lần đầu
+        if (e.created)
+            j["name"] = nameOf(players, e.state.id);
+        state_json["players"].push_back(std::move(j));
+    }
+
+    state_json["items"] = json::array();
+    for (const auto &it : msg.items)
+        state_json["items"].push_back({{"id", it.id}, {"x", it.x}, {"y", it.y}});
+
+    state_json["bullets"] = json::array();
+    for (const auto &e : msg.bullets)
+    {
+        json j = {{"id", e.state.id}, {"x", e.state.x}, {"y", e.state.y}};
+        if (e.created)
+        {
+            // Người bắn có thể đã rời trận: khi đó gửi tên rỗng
+            j["dx"] = e.state.dx;
+            j["dy"] = e.state.dy;
+            j["shooter"] = nameOf(players, e.state.shooter);
+        }
+        state_json["bullets"].push_back(std::move(j));
+    }
+
+    if (msg.baseline != 0)
+    {
+        state_json["baseline"] = msg.baseline;
+        state_json["removed"] = {{"players", msg.removedPlayers}, {"items", msg.removedItems}, {"bullets", msg.removedBullets}};
+    }
+
+    state_json["leaderboard"] = json::array();
+    for (const auto &e : msg.leaderboard)
+        state_json["leaderboard"].push_back({{"name", nameOf(players, e.id)}, {"score", e.score}});
+    state_json["playerCount"] = msg.playerCount;
+
+    out = state_json.dump();
+    out.push_back('\n');
+}
+
+void encodeSnapshotBinary(const SnapshotMessage &msg, const PlayerStore &players, std::string &out)
+{
+    out.clear();
+    size_t frame = beginBinaryFrame(out);
+    ByteWriter w(out);
+
+    w.u8(kSnapshotMessageType);
+    w.u8(kSnapshotVersion);
+    w.varint(msg.tick);
+    w.varint(msg.baseline);
+    w.varint(msg.playerCount);
+
+    w.varint(msg.players.size());
+    for (const auto &e : msg.players)
+    {
+        w.varint(e.state.id);
+        w.u8(e.created ? 1 : 0);
+        w.svarint(e.state.x);
+        w.svarint(e.state.y);
+        w.svarint(e.state.score);
+        if (e.created)
+            w.string(nameOf(players, e.state.id));
+    }
+
+    w.varint(msg.items.size());
+    for (const auto &it : msg.items)
+    {
+        w.varint(it.id);
+        w.svarint(it.x);
+        w.svarint(it.y);
+    }
+
+    w.varint(msg.bullets.size());
+    for (const auto &e : msg.bullets)
+    {
+        w.varint(e.state.id);
+        w.u8(e.created ? 1 : 0);
+        w.svarint(e.state.x);
+        w.svarint(e.state.y);
+        if (e.created)
+        {
+            w.svarint(std::llround(e.state.dx * kDirectionScale));
+            w.svarint(std::llround(e.state.dy * kDirectionScale));
+            w.varint(e.state.shooter);
+        }
+    }
+
+    if (msg.baseline != 0)
+    {
+        for (const auto *ids : {&msg.removedPlayers, &msg.removedItems, &msg.removedBullets})
+        {
+            w.varint(ids->size());
+            for (EntityId id : *ids)
+                w.varint(id);
+        }
+    }
+
+    w.varint(msg.leaderboard.size());
+    for (const auto &e : msg.leaderboard)
+    {
+        w.varint(e.id);
+        w.svarint(e.score);
+        w.string(nameOf(players, e.id));
+    }
+
+    patchBinaryFrame(out, frame);
+}
@@ -0,0 +1,79 @@
+#ifndef SNAPSHOT_CODEC_H
+#define SNAPSHOT_CODEC_H
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "entityStore.h"
+#include "snapshot.h"
+
+// Định dạng snapshot client đã chọn khi join
+enum class WireEncoding : uint8_t
+{
+    Json,   // JSON kết thúc bằng '\n' (mặc định, client cũ)
+    Binary, // khung nhị phân "bin1" (xem snapshotCodec.cpp)
+};
+
+// Tên encoding client gửi trong "encodings" khi join
+constexpr const char *kBinaryEncodingName = "bin1";
+constexpr uint8_t kSnapshotMessageType = 0x01;
+constexpr uint8_t kSnapshotVersion = 1;
+
+// Nội dung một snapshot gửi cho một client, độc lập với định dạng dây.
+// Gameplay điền vào (tái sử dụng bộ nhớ mỗi tick), bộ mã hoá ghi ra buffer.
+struct SnapshotMessage
+{
+    struct PlayerEntry
+    {
+        PlayerState state;
+        bool created;
+    };
+    struct BulletEntry
+    {
+        BulletState state;
+        bool created;
+    };
+    struct LeaderboardEntry
+    {
+        EntityId id;
+        int score;
+    };
+
+    uint32_t tick = 0;
+    // 0 nghĩa là snapshot đầy đủ; khác 0 là tick mốc của delta
+    uint32_t baseline = 0;
+    uint32_t playerCount = 0;
+
+    std::vector<PlayerEntry> players;
+    std::vector<ItemState> items;
+    std::vector<BulletEntry> bullets;
+    std::vector<EntityId> removedPlayers;
+    std::vector<EntityId> removedItems;
+    std::vector<EntityId> removedBullets;
+    std::vector<LeaderboardEntry> leaderboard;
+
+    void clear();
+};
+
+// Số byte ước lượng của từng phần snapshot trên dây (chưa tính tên người chơi), dùng cho
+// ngân sách băng thông mỗi client. Chỉ cần sát thực tế, không cần chính xác tuyệt đối.
+struct SnapshotCost
+{
+    size_t header;           // tick, baseline, playerCount, độ dài các mảng
+    size_t player;           // id, x, y, score
+    size_t item;             // id, x, y
+    size_t bullet;           // id, x, y
+    size_t created;          // thêm khi thực thể mới: cờ, hướng đạn, người bắn...
+    size_t removed;          // một id bị xoá
+    size_t leaderboardEntry; // id/score, chưa tính tên
+};
+
+const SnapshotCost &snapshotCost(WireEncoding encoding);
+
+// JSON tương thích client cũ (kết thúc bằng '\n'); tên tra trong players
+void encodeSnapshotJson(const SnapshotMessage &msg, const PlayerStore &players, std::string &out);
+
+// Khung nhị phân bin1 ghi thẳng vào out (out được xoá trước, giữ capacity)
+void encodeSnapshotBinary(const SnapshotMessage &msg, const PlayerStore &players, std::string &out);
+
+#endif // SNAPSHOT_CODEC_H
@@ -0,0 +1,68 @@
+#include "spatialGrid.h"
+
+SpatialGrid::SpatialGrid(int cellSize)
+    : cellSize_(cellSize > 0 ? cellSize : 1)
+{
+}
+
+void SpatialGrid::clear()
+{
+    pendingIndex_.clear();
+    pendingX_.clear();
+    pendingY_.clear();
+    indices_.clear();
+    xs_.clear();
+    ys_.clear();
+}
+
+void SpatialGrid::insert(uint32_t index, int x, int y)
+{
+    pendingIndex_.push_back(index);
+    pendingX_.push_back(x);
+    pendingY_.push_back(y);
+}
+
+void SpatialGrid::build()
+{
+    const size_t n = pendingIndex_.size();
+
+    // Số bucket là lũy thừa của 2, khoảng gấp đôi số điểm để ít va chạm băm
+    uint32_t bucketCount = 16;
+    while (bucketCount < n * 2)
+        bucketCount <<= 1;
+    bucketMask_ = bucketCount - 1;
+
+    bucketStart_.assign(bucketCount + 1, 0);
+    if (visited_.size() != bucketCount)
+    {
+        visited_.assign(bucketCount, 0);
+        stamp_ = 0;
+    }
+
+    // Đếm số điểm mỗi bucket
+    pendingBucket_.resize(n);
+    for (size_t i = 0; i < n; ++i)
+    {
+        const uint32_t b = bucketOf(cellOf(pendingX_[i]), cellOf(pendingY_[i]));
+        pendingBucket_[i] = b;
+        ++bucketStart_[b];
+    }
+
+    // Cộng dồn: bucketStart_[b] tạm thời là vị trí kết thúc của bucket b
+    for (uint32_t b = 1; b < bucketCount; ++b)
+        bucketStart_[b] += bucketStart_[b - 1];
+    bucketStart_[bucketCount] = static_cast<uint32_t>(n);
+
+    // Rải ngược để sau vòng lặp bucketStart_[b] trở thành vị trí bắt đầu,
+    // đồng thời giữ nguyên thứ tự insert trong cùng một bucket
+    indices_.resize(n);
+    xs_.resize(n);
+    ys_.resize(n);
+    for (size_t i = n; i-- > 0;)
+    {
+        const uint32_t pos = --bucketStart_[pendingBucket_[i]];
+        indices_[pos] = pendingIndex_[i];
+        xs_[pos] = pendingX_[i];
+        ys_[pos] = pendingY_[i];
+    }
+}
@@ -0,0 +1,135 @@
+#ifndef SPATIAL_GRID_H
+#define SPATIAL_GRID_H
+
+#include <cstdint>
+#include <cstddef>
+#include <vector>
+#include <algorithm>
+
+// Khối ứng viên dạng SoA (chỉ số + toạ độ liền kề) để kernel khoảng cách xử lý một lượt
+struct CandidateBlock
+{
+    std::vector<uint32_t> index;
+    std::vector<int> x, y;
+
+    void clear()
+    {
+        index.clear();
+        x.clear();
+        y.clear();
+    }
+    uint32_t size() const { return static_cast<uint32_t>(index.size()); }
+};
+
+// Lưới băm không gian đều: thế giới được chia thành các ô vuông cellSize x cellSize,
+// mỗi ô được băm vào một bucket. Lưới được xây lại mỗi tick (O(N)) để mỗi thực thể
+// chỉ cần kiểm tra với các thực thể ở ô lân cận thay vì toàn bộ thế giới.
+class SpatialGrid
+{
+public:
+    explicit SpatialGrid(int cellSize);
+
+    // Xoá các điểm nhưng giữ lại bộ nhớ đã cấp phát cho tick sau
+    void clear();
+
+    // Thêm một điểm; index là vị trí của thực thể trong mảng gốc
+    void insert(uint32_t index, int x, int y);
+
+    // Sắp xếp các điểm theo bucket (counting sort), gọi sau khi insert xong
+    void build();
+
+    // Gọi fn(index, xs, ys, n) cho từng dải điểm liền kề (mỗi bucket một dải) có thể
+    // nằm trong bán kính radius quanh (x, y). Đây chỉ là tập ứng viên: người gọi
+    // vẫn phải kiểm tra khoảng cách chính xác.
+    template <typename Fn>
+    void queryRanges(int x, int y, int radius, Fn &&fn) const
+    {
+        if (indices_.empty())
+            return;
+
+        const int64_t cx0 = cellOf(static_cast<int64_t>(x) - radius);
+        const int64_t cx1 = cellOf(static_cast<int64_t>(x) + radius);
+        const int64_t cy0 = cellOf(static_cast<int64_t>(y) - radius);
+        const int64_t cy1 = cellOf(static_cast<int64_t>(y) + radius);
+
+        // Nhiều ô có thể băm trùng một bucket: đánh dấu để không duyệt lặp
+        if (++stamp_ == 0)
+        {
+            std::fill(visited_.begin(), visited_.end(), 0);
+            stamp_ = 1;
+        }
+
+        for (int64_t cy = cy0; cy <= cy1; ++cy)
+        {
+            for (int64_t cx = cx0; cx <= cx1; ++cx)
+            {
+                const uint32_t bucket = bucketOf(cx, cy);
+                if (visited_[bucket] == stamp_)
+                    continue;
+                visited_[bucket] = stamp_;
+
+                const uint32_t begin = bucketStart_[bucket];
+                const uint32_t end = bucketStart_[bucket + 1];
+                if (begin != end)
+                    fn(&indices_[begin], &xs_[begin], &ys_[begin], end - begin);
+            }
+        }
+    }
+
+    // Gọi fn(index) cho từng điểm ứng viên
+    template <typename Fn>
+    void query(int x, int y, int radius, Fn &&fn) const
+    {
+        queryRanges(x, y, radius, [&](const uint32_t *idx, const int *, const int *, uint32_t n)
+                    {
+            for (uint32_t i = 0; i < n; ++i)
+                fn(idx[i]); });
+    }
+
+    // Gom toàn bộ ứng viên quanh (x, y) vào block (ghi đè nội dung cũ)
+    void gather(int x, int y, int radius, CandidateBlock &block) const
+    {
+        block.clear();
+        queryRanges(x, y, radius, [&](const uint32_t *idx, const int *xs, const int *ys, uint32_t n)
+                    {
+            block.index.insert(block.index.end(), idx, idx + n);
+            block.x.insert(block.x.end(), xs, xs + n);
+            block.y.insert(block.y.end(), ys, ys + n); });
+    }
+
+    int cellSize() const { return cellSize_; }
+    size_t size() const { return indices_.size(); }
+
+private:
+    int64_t cellOf(int64_t v) const
+    {
+        // Chia làm tròn xuống để toạ độ âm vẫn vào đúng ô
+        return v >= 0 ? v / cellSize_ : -((-v + cellSize_ - 1) / cellSize_);
+    }
+
+    uint32_t bucketOf(int64_t cx, int64_t cy) const
+    {
+        const uint32_t h = static_cast<uint32_t>(cx) * 73856093u ^ static_cast<uint32_t>(cy) * 19349663u;
+        return h & bucketMask_;
+    }
+
+    int cellSize_;
+    uint32_t bucketMask_ = 0;
+
+    // Dữ liệu thô giữa insert và build
+    std::vector<uint32_t> pendingIndex_;
+    std::vector<int> pendingX_;
+    std::vector<int> pendingY_;
+    std::vector<uint32_t> pendingBucket_;
+
+    // Dữ liệu đã sắp xếp theo bucket: điểm của bucket b nằm trong [bucketStart_[b], bucketStart_[b+1])
+    std::vector<uint32_t> bucketStart_;
+    std::vector<uint32_t> indices_;
+    std::vector<int> xs_;
+    std::vector<int> ys_;
+
+    mutable std::vector<uint32_t> visited_;
+    mutable uint32_t stamp_ = 0;
+};
+
+#endif // SPATIAL_GRID_H
@@ -0,0 +1,114 @@
+#include "tickStats.h"
+#include <algorithm>
+#include <sstream>
+#include <iomanip>
+
+int LatencyHistogram::indexOf(uint64_t v)
+{
+    // Giá trị nhỏ: mỗi giá trị một bucket
+    if (v < 2 * kSubBuckets)
+        return static_cast<int>(v);
+    // Giữ lại kSubBucketBits + 1 bit cao nhất
+    const int msb = 63 - __builtin_clzll(v);
+    const int shift = msb - kSubBucketBits;
+    return 2 * kSubBuckets + (shift - 1) * kSubBuckets + static_cast<int>((v >> shift) - kSubBuckets);
+}
+
+uint64_t LatencyHistogram::upperBoundOf(int index)
+{
+    if (index < 2 * kSubBuckets)
+        return static_cast<uint64_t>(index);
+    const int shift = (index - 2 * kSubBuckets) / kSubBuckets + 1;
+    const uint64_t sub = static_cast<uint64_t>((index - 2 * kSubBuckets) % kSubBuckets + kSubBuckets);
+    return ((sub + 1) << shift) - 1;
+}
+
+void LatencyHistogram::record(uint64_t ns)
+{
+    counts_[indexOf(ns)]++;
+    count_++;
+    sum_ += ns;
+    if (ns > max_)
+        max_ = ns;
+}
+
+void LatencyHistogram::reset()
+{
+    counts_.fill(0);
+    count_ = 0;
+    sum_ = 0;
+    max_ = 0;
+}
+
+void LatencyHistogram::merge(const LatencyHistogram &other)
+{
+    for (size_t i = 0; i < counts_.size(); ++i)
+        counts_[i] += other.counts_[i];
+    count_ += other.count_;
+    sum_ += other.sum_;
+    if (other.max_ > max_)
+        max_ = other.max_;
+}
+
+uint64_t LatencyHistogram::percentile(double q) const
+{
+    if (count_ == 0)
+        return 0;
+    const uint64_t target = static_cast<uint64_t>(q * static_cast<double>(count_ - 1)) + 1;
+    uint64_t seen = 0;
+    for (int i = 0; i < kBucketCount; ++i)
+    {
+        seen += counts_[i];
+        if (seen >= target)
+            return std::min(upperBoundOf(i), max_);
+    }
+    return max_;
+}
+
+const char *tickPhaseName(TickPhase phase)
+{
+    switch (phase)
+    {
+    case TickPhase::Input:
+        return "input";
+    case TickPhase::Collection:
+        return "collection";
+    case TickPhase::Bullets:
+        return "bullets";
+    case TickPhase::Collisions:
+        return "collisions";
+    case TickPhase::Spawn:
+        return "spawn";
+    case TickPhase::Broadcast:
+        return "broadcast";
+    case TickPhase::Total:
+        return "total";
+    default:
+        return "?";
+    }
+}
+
+std::string TickStats::summary(uint64_t budgetNs) const
+{
+    auto us = [](uint64_t ns)
+    { return static_cast<double>(ns) / 1000.0; };
+
+    std::ostringstream os;
+    os << std::fixed << std::setprecision(1);
+    os << "ticks=" << ticks << " overruns=" << overruns << " skipped=" << skippedTicks
+       << " skippedBroadcasts=" << skippedBroadcasts << " broadcastEvery=" << broadcastDivisor
+       << " inputs=" << inputs << " droppedInputs=" << droppedInputs << " deferredUpdates=" << deferredUpdates
+       << " throttledShots=" << throttledShots;
+
+    const LatencyHistogram &total = phase(TickPhase::Total);
+    if (budgetNs)
+        os << " budget(p99)=" << 100.0 * static_cast<double>(total.percentile(0.99)) / static_cast<double>(budgetNs) << "%";
+
+    for (size_t p = 0; p < phases.size(); ++p)
+    {
+        const LatencyHistogram &h = phases[p];
+        os << " | " << tickPhaseName(static_cast<TickPhase>(p)) << " p50=" << us(h.percentile(0.5))
+           << "us p99=" << us(h.percentile(0.99)) << "us max=" << us(h.max()) << "us";
+    }
+    return os.str();
+}
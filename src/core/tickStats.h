@@ -0,0 +1,73 @@
+#ifndef TICK_STATS_H
+#define TICK_STATS_H
+
+#include <array>
+#include <cstdint>
+#include <string>
+
+// Histogram độ trễ kiểu HDR (log-linear): mỗi bậc lũy thừa 2 chia 16 bucket con,
+// sai số tương đối ~6%, ghi O(1), không cấp phát. Giá trị tính bằng nano giây.
+class LatencyHistogram
+{
+public:
+    void record(uint64_t ns);
+    void reset();
+    void merge(const LatencyHistogram &other);
+
+    uint64_t count() const { return count_; }
+    uint64_t max() const { return max_; }
+    uint64_t mean() const { return count_ ? sum_ / count_ : 0; }
+    // q trong [0, 1], ví dụ 0.99 cho p99 (trả về cận trên của bucket)
+    uint64_t percentile(double q) const;
+
+private:
+    static constexpr int kSubBucketBits = 4;
+    static constexpr int kSubBuckets = 1 << kSubBucketBits;
+    static constexpr int kBucketCount = 2 * kSubBuckets + (64 - kSubBucketBits - 1) * kSubBuckets;
+
+    static int indexOf(uint64_t v);
+    static uint64_t upperBoundOf(int index);
+
+    std::array<uint64_t, kBucketCount> counts_{};
+    uint64_t count_ = 0;
+    uint64_t sum_ = 0;
+    uint64_t max_ = 0;
+};
+
+// Các pha của một tick game
+enum class TickPhase : uint8_t
+{
+    Input,
+    Collection,
+    Bullets,
+    Collisions,
+    Spawn,
+    Broadcast,
+    Total,
+    Count
+};
+
+const char *tickPhaseName(TickPhase phase);
+
+// Thống kê thời gian tick của một phòng
+struct TickStats
+{
+    std::array<LatencyHistogram, static_cast<size_t>(TickPhase::Count)> phases;
+    uint64_t ticks = 0;
+    uint64_t overruns = 0;          // tick kết thúc sau hạn của tick kế tiếp
+    uint64_t skippedTicks = 0;      // tick bị bỏ qua để bắt kịp lịch
+    uint64_t skippedBroadcasts = 0; // broadcast bị bỏ khi đang giảm tần suất
+    uint32_t broadcastDivisor = 1;  // broadcast mỗi N tick (chính sách degrade)
+    uint64_t inputs = 0;            // lệnh đầu vào đã áp dụng
+    uint64_t droppedInputs = 0;     // lệnh bị bỏ vì hàng đợi đầy
+    uint64_t deferredUpdates = 0;   // thay đổi thực thể hoãn sang tick sau vì hết ngân sách byte
+    uint64_t throttledShots = 0;    // lệnh bắn bị bỏ vì chưa hết cooldown
+
+    LatencyHistogram &phase(TickPhase p) { return phases[static_cast<size_t>(p)]; }
+    const LatencyHistogram &phase(TickPhase p) const { return phases[static_cast<size_t>(p)]; }
+
+    // Một dòng tóm tắt để log; budgetNs là thời gian cho phép của một tick
+    std::string summary(uint64_t budgetNs) const;
+};
+
+#endif // TICK_STATS_H
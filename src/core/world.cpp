@@ -0,0 +1,296 @@
+#include "world.h"
+#include <algorithm>
+#include <iostream>
+
+namespace
+{
+    // Làm tròn lên để cửa sổ bù trễ không ngắn hơn cấu hình; rewind lưu bằng uint8_t
+    uint32_t rewindTicksFor(const GameplayConfig &config)
+    {
+        const int64_t ticks = (int64_t(config.lagCompensationMs) * config.tickRate + 999) / 1000;
+        return static_cast<uint32_t>(std::clamp<int64_t>(ticks, 0, UINT8_MAX));
+    }
+}
+
+World::World(const GameplayConfig &config, uint32_t seed)
+    : seed_(seed),
+      spawnIntervalTicks_(static_cast<uint32_t>(std::max(1, config.tickRate * kItemSpawnIntervalSec))),
+      maxRewindTicks_(rewindTicksFor(config)),
+      rng_(seed),
+      itemGrid_(std::max(kItemPickupRadius, kBulletHitRadius)),
+      playerGrid_(std::max(kItemPickupRadius, kBulletHitRadius)),
+      history_(maxRewindTicks_),
+      rewindGridTick_(maxRewindTicks_, 0)
+{
+    rewindGrids_.reserve(maxRewindTicks_);
+    for (uint32_t r = 0; r < maxRewindTicks_; ++r)
+        rewindGrids_.emplace_back(std::max(kItemPickupRadius, kBulletHitRadius));
+}
+
+EntityId World::apply(const InputCommand &cmd)
+{
+    if (cmd.type == InputType::Join)
+        return addPlayer(cmd.client, cmd.name);
+    if (cmd.type == InputType::Leave)
+        return removePlayer(cmd.client);
+    if (cmd.type == InputType::Resume)
+        return rebindPlayer(cmd.previous, cmd.client);
+
+    EntityId e = playerOf(cmd.client);
+    if (e == kInvalidEntity)
+        return kInvalidEntity;
+
+    switch (cmd.type)
+    {
+    case InputType::Move:
+    {
+        uint32_t i = players_.indexOf(e);
+        players_.x[i] = cmd.x;
+        players_.y[i] = cmd.y;
+        return e;
+    }
+    case InputType::Shoot:
+        // Người bắn là người chơi gắn với client, không tin tên do client gửi
+        createBullet(e, cmd.x, cmd.y, cmd.dx, cmd.dy, static_cast<uint8_t>(std::min<uint32_t>(cmd.rewind, maxRewindTicks_)));
+        return e;
+    default:
+        return kInvalidEntity;
+    }
+}
+
+EntityId World::playerOf(ClientId client) const
+{
+    auto it = playerByClient_.find(client);
+    return it != playerByClient_.end() ? it->second : kInvalidEntity;
+}
+
+uint64_t World::checksum() const
+{
+    uint64_t h = 1469598103934665603ull;
+    auto mix = [&h](uint64_t v)
+    {
+        for (int i = 0; i < 8; ++i)
+        {
+            h ^= (v >> (i * 8)) & 0xFF;
+            h *= 1099511628211ull;
+        }
+    };
+
+    mix(tick_);
+    for (uint32_t i = 0; i < players_.size(); ++i)
+    {
+        mix(players_.id[i]);
+        mix(static_cast<uint32_t>(players_.x[i]));
+        mix(static_cast<uint32_t>(players_.y[i]));
+        mix(static_cast<uint32_t>(players_.score[i]));
+    }
+    for (uint32_t i = 0; i < items_.size(); ++i)
+    {
+        mix(items_.id[i]);
+        mix(static_cast<uint32_t>(items_.x[i]));
+        mix(static_cast<uint32_t>(items_.y[i]));
+    }
+    for (uint32_t i = 0; i < bullets_.size(); ++i)
+    {
+        mix(bullets_.id[i]);
+        mix(static_cast<uint32_t>(bullets_.x[i]));
+        mix(static_cast<uint32_t>(bullets_.y[i]));
+        mix(bullets_.shooter[i]);
+    }
+    return h;
+}
+
+EntityId World::addPlayer(ClientId client, const std::string &name)
+{
+    if (playerByClient_.find(client) != playerByClient_.end())
+        return kInvalidEntity;
+    int x = randomInt(50, 549);
+    int y = randomInt(50, 349);
+    std::string playerName = name.empty() ? ("P" + std::to_string(nextGuestId_++)) : name;
+    EntityId e = players_.create(client, playerName, x, y);
+    playerByClient_.emplace(client, e);
+    if (logging_)
+        std::cout << "[Gameplay] Added player " << playerName << "\n";
+    return e;
+}
+
+EntityId World::removePlayer(ClientId client)
+{
+    auto it = playerByClient_.find(client);
+    if (it == playerByClient_.end())
+        return kInvalidEntity;
+
+    EntityId e = it->second;
+    uint32_t i = players_.indexOf(e);
+    if (logging_)
+        std::cout << "[Gameplay] Removing player " << players_.name[i] << "\n";
+    players_.removeAt(i);
+    playerByClient_.erase(it);
+    return e;
+}
+
+EntityId World::rebindPlayer(ClientId previous, ClientId client)
+{
+    // Giữ nguyên vị trí, điểm và id; chỉ đổi client nhận lệnh và snapshot
+    auto it = playerByClient_.find(previous);
+    if (it == playerByClient_.end() || previous == client || playerByClient_.count(client))
+        return kInvalidEntity;
+
+    EntityId e = it->second;
+    uint32_t i = players_.indexOf(e);
+    players_.client[i] = client;
+    playerByClient_.erase(it);
+    playerByClient_.emplace(client, e);
+    if (logging_)
+        std::cout << "[Gameplay] Resumed player " << players_.name[i] << "\n";
+    return e;
+}
+
+void World::spawnItem()
+{
+    EntityId e = items_.create(randomInt(50, 549), randomInt(50, 349));
+    if (logging_)
+        std::cout << "[Gameplay] Spawned item " << e << "\n";
+}
+
+void World::checkItemCollection()
+{
+    itemGrid_.clear();
+    for (uint32_t i = 0; i < items_.size(); ++i)
+        itemGrid_.insert(i, items_.x[i], items_.y[i]);
+    itemGrid_.build();
+
+    removed_.assign(items_.size(), 0);
+    bool anyCollected = false;
+
+    for (uint32_t p = 0; p < players_.size(); ++p)
+    {
+        itemGrid_.gather(players_.x[p], players_.y[p], kItemPickupRadius, candidates_);
+        hits_.resize(candidates_.size());
+        uint32_t n = withinRadius(players_.x[p], players_.y[p], candidates_.x.data(), candidates_.y.data(),
+                                  candidates_.size(), kItemPickupRadius, hits_.data());
+        for (uint32_t k = 0; k < n; ++k)
+        {
+            uint32_t i = candidates_.index[hits_[k]];
+            if (removed_[i])
+                continue;
+            removed_[i] = 1;
+            anyCollected = true;
+            players_.score[p] += 1;
+            if (logging_)
+                std::cout << "[Gameplay] Player " << players_.name[p] << " collected " << items_.id[i] << "\n";
+        }
+    }
+
+    // Xoá từ cuối lên để phần tử được đổi chỗ vào luôn là phần tử còn giữ
+    if (anyCollected)
+    {
+        for (uint32_t i = items_.size(); i-- > 0;)
+            if (removed_[i])
+                items_.removeAt(i);
+    }
+}
+
+void World::createBullet(EntityId shooter, int x, int y, double dx, double dy, uint8_t rewind)
+{
+    EntityId e = bullets_.create(shooter, x, y, dx, dy, rewind);
+    if (logging_)
+        std::cout << "[Gameplay] Bullet " << e << " from " << shooter << "\n";
+}
+
+void World::updateBullets()
+{
+    // Duyệt ngược để swap-remove không bỏ sót phần tử chưa cập nhật
+    for (uint32_t i = bullets_.size(); i-- > 0;)
+    {
+        int x = static_cast<int>(bullets_.x[i] + bullets_.dx[i] * kBulletSpeed);
+        int y = static_cast<int>(bullets_.y[i] + bullets_.dy[i] * kBulletSpeed);
+        if (x < 0 || x > 2000 || y < 0 || y > 2000)
+        {
+            bullets_.removeAt(i);
+            continue;
+        }
+        bullets_.x[i] = x;
+        bullets_.y[i] = y;
+    }
+}
+
+void World::checkBulletCollisions()
+{
+    playerGrid_.clear();
+    for (uint32_t i = 0; i < players_.size(); ++i)
+        playerGrid_.insert(i, players_.x[i], players_.y[i]);
+    playerGrid_.build();
+
+    removed_.assign(bullets_.size(), 0);
+    bool anyHit = false;
+
+    for (uint32_t b = 0; b < bullets_.size(); ++b)
+    {
+        const EntityId shooter = bullets_.shooter[b];
+
+        // Đạn có bù trễ được xét theo vị trí người chơi ở tick mà người bắn nhìn thấy
+        // (suốt đời viên đạn); nếu tick đó không còn trong lịch sử thì xét hiện tại
+        const uint32_t rewind = bullets_.rewind[b];
+        const PositionHistory::Frame *frame = rewind > 0 && rewind < tick_ ? history_.at(tick_ - rewind) : nullptr;
+        const SpatialGrid &grid = frame ? rewindGrid(rewind, *frame) : playerGrid_;
+        const std::vector<EntityId> &ids = frame ? frame->id : players_.id;
+
+        grid.gather(bullets_.x[b], bullets_.y[b], kBulletHitRadius, candidates_);
+        hits_.resize(candidates_.size());
+        uint32_t n = withinRadius(bullets_.x[b], bullets_.y[b], candidates_.x.data(), candidates_.y.data(),
+                                  candidates_.size(), kBulletHitRadius, hits_.data());
+
+        // Khi nhiều người chơi cùng trong tầm, chọn người có chỉ số nhỏ nhất (trong
+        // frame được xét) để kết quả không phụ thuộc thứ tự trong bucket. Người chơi
+        // đã rời phòng sau tick quá khứ thì bỏ qua.
+        uint32_t hit = kNoIndex;
+        uint32_t best = kNoIndex;
+        for (uint32_t k = 0; k < n; ++k)
+        {
+            uint32_t p = candidates_.index[hits_[k]];
+            if (p >= best || ids[p] == shooter)
+                continue;
+            uint32_t current = frame ? players_.indexOf(ids[p]) : p;
+            if (current == kNoIndex)
+                continue;
+            best = p;
+            hit = current;
+        }
+
+        if (hit != kNoIndex)
+        {
+            removed_[b] = 1;
+            anyHit = true;
+            players_.score[hit] = std::max(0, players_.score[hit] - 1);
+            if (logging_)
+                std::cout << "[Gameplay] Player " << players_.name[hit] << " hit by " << shooter << "\n";
+        }
+    }
+
+    if (anyHit)
+    {
+        for (uint32_t b = bullets_.size(); b-- > 0;)
+            if (removed_[b])
+                bullets_.removeAt(b);
+    }
+}
+
+const SpatialGrid &World::rewindGrid(uint32_t rewind, const PositionHistory::Frame &frame)
+{
+    SpatialGrid &grid = rewindGrids_[rewind - 1];
+    if (rewindGridTick_[rewind - 1] != frame.tick)
+    {
+        grid.clear();
+        for (uint32_t i = 0; i < frame.id.size(); ++i)
+            grid.insert(i, frame.x[i], frame.y[i]);
+        grid.build();
+        rewindGridTick_[rewind - 1] = frame.tick;
+    }
+    return grid;
+}
+
+int World::randomInt(int lo, int hi)
+{
+    return std::uniform_int_distribution<int>(lo, hi)(rng_);
+}
@@ -0,0 +1,152 @@
+#ifndef WORLD_H
+#define WORLD_H
+
+#include <cstdint>
+#include <random>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "distanceKernel.h"
+#include "entityStore.h"
+#include "gameplayConfig.h"
+#include "positionHistory.h"
+#include "snapshotCodec.h"
+#include "spatialGrid.h"
+#include "tickStats.h"
+
+// Bán kính va chạm (đơn vị toạ độ thế giới)
+constexpr int kItemPickupRadius = 20;
+constexpr int kBulletHitRadius = 15;
+
+// Tốc độ đạn mỗi tick
+constexpr double kBulletSpeed = 15.0;
+
+// Chu kỳ sinh vật phẩm (đếm theo tick để mô phỏng tất định)
+constexpr int kItemSpawnIntervalSec = 5;
+
+// Lệnh đầu vào đã giải mã từ tin nhắn của client
+enum class InputType : uint8_t
+{
+    Join,
+    Leave,
+    Move,
+    Ack,
+    Shoot,
+    Resume, // client mới nhận lại người chơi của client cũ (nối lại trong thời gian chờ)
+};
+
+struct InputCommand
+{
+    InputType type = InputType::Move;
+    ClientId client = 0;
+    int x = 0, y = 0;
+    double dx = 0.0, dy = 0.0;
+    uint32_t tick = 0;
+    WireEncoding encoding = WireEncoding::Json;
+    std::string name;
+    uint64_t receivedNs = 0; // thời điểm nhận (steady_clock), chỉ dùng khi ghi log
+    uint32_t rttMicros = 0;  // RTT của kết nối lúc nhận, chỉ dùng để tính rewind
+    uint8_t rewind = 0;      // Shoot: số tick lùi lại để xét trúng đạn (đã chặn, được ghi log)
+    ClientId previous = 0;   // Resume: client đang giữ người chơi (được ghi log)
+    uint64_t token = 0;      // Join: token nối lại client gửi kèm, chỉ Gameplay dùng
+};
+
+// Mô phỏng thế giới của một phòng, không phụ thuộc tầng mạng. Với cùng seed và cùng
+// chuỗi lệnh áp dụng ở cùng tick, kết quả luôn giống nhau: server, công cụ replay và
+// benchmark chạy chung code tick này.
+class World
+{
+public:
+    World(const GameplayConfig &config, uint32_t seed);
+
+    // Áp dụng một lệnh ở ranh giới tick. Trả về người chơi chịu tác động
+    // (người mới với Join, người bị xoá với Leave, người được gắn sang client mới với
+    // Resume), kInvalidEntity nếu lệnh bị bỏ qua.
+    EntityId apply(const InputCommand &cmd);
+
+    // Chạy một tick; onPhase(phase) được gọi ngay sau khi mỗi pha kết thúc
+    template <typename OnPhase>
+    void step(OnPhase &&onPhase)
+    {
+        ++tick_;
+        checkItemCollection();
+        onPhase(TickPhase::Collection);
+        updateBullets();
+        onPhase(TickPhase::Bullets);
+        checkBulletCollisions();
+        // Người chơi không di chuyển trong step nên đây đã là vị trí cuối tick
+        if (maxRewindTicks_ > 0)
+            history_.record(tick_, players_);
+        onPhase(TickPhase::Collisions);
+        if (tick_ % spawnIntervalTicks_ == 0)
+            spawnItem();
+        onPhase(TickPhase::Spawn);
+    }
+    void step()
+    {
+        step([](TickPhase) {});
+    }
+
+    uint32_t tick() const { return tick_; }
+    uint32_t seed() const { return seed_; }
+
+    // Số tick tối đa được lùi lại khi xét trúng đạn (0 = tắt bù trễ)
+    uint32_t maxRewindTicks() const { return maxRewindTicks_; }
+
+    const PlayerStore &players() const { return players_; }
+    const ItemStore &items() const { return items_; }
+    const BulletStore &bullets() const { return bullets_; }
+    EntityId playerOf(ClientId client) const;
+
+    // Băm toàn bộ trạng thái (FNV-1a) để so sánh hai lần chạy
+    uint64_t checksum() const;
+
+    // Sinh một vật phẩm ở vị trí ngẫu nhiên (vòng lặp tự gọi theo chu kỳ)
+    void spawnItem();
+
+    // Tắt log từng sự kiện khi replay/benchmark
+    void setLogging(bool enabled) { logging_ = enabled; }
+
+private:
+    EntityId addPlayer(ClientId client, const std::string &name);
+    EntityId removePlayer(ClientId client);
+    EntityId rebindPlayer(ClientId previous, ClientId client);
+    void createBullet(EntityId shooter, int x, int y, double dx, double dy, uint8_t rewind);
+    void checkItemCollection();
+    void updateBullets();
+    void checkBulletCollisions();
+    const SpatialGrid &rewindGrid(uint32_t rewind, const PositionHistory::Frame &frame);
+    int randomInt(int lo, int hi);
+
+    uint32_t seed_;
+    uint32_t tick_ = 0;
+    uint32_t spawnIntervalTicks_;
+    uint32_t maxRewindTicks_;
+    bool logging_ = true;
+
+    // Dữ liệu thế giới lưu theo cột (SoA), truy cập qua EntityId
+    PlayerStore players_;
+    std::unordered_map<ClientId, EntityId> playerByClient_;
+    ItemStore items_;
+    BulletStore bullets_;
+
+    std::mt19937 rng_;
+
+    // Số thứ tự cho tên mặc định của người chơi
+    uint32_t nextGuestId_ = 1;
+
+    // Lưới không gian dựng lại mỗi tick cho kiểm tra va chạm
+    SpatialGrid itemGrid_;
+    SpatialGrid playerGrid_;
+    std::vector<uint8_t> removed_;
+    CandidateBlock candidates_;
+    std::vector<uint32_t> hits_;
+
+    // Vị trí người chơi ở maxRewindTicks_ tick gần nhất cho bù trễ. Lưới của một tick
+    // quá khứ chỉ dựng khi có đạn cần lùi tới đó, tối đa một lần mỗi tick.
+    PositionHistory history_;
+    std::vector<SpatialGrid> rewindGrids_;    // chỉ số = rewind - 1
+    std::vector<uint32_t> rewindGridTick_;    // tick của frame đang dựng trong lưới
+};
+
+#endif // WORLD_H
@@ -1,6 +1,8 @@
 #pragma once
 #include <string>
 #include <cstdint>
+#include <functional>
+#include "../transport/transport.h"
 
 struct ClientContext
 {
@@ -10,12 +12,13 @@ struct ClientContext
     std::string userId;
     std::string playerId;
 
-    // Hàm gửi message về client
-    std::function<void(const std::string &)> sendMessage;
+    // Hàm gửi message về client trên stream của lớp lưu lượng tương ứng
+    std::function<void(const std::string &, TrafficClass)> sendMessage;
 
     // Push notification
     void pushNotification(const std::string &title, const std::string &message)
     {
-        sendMessage("{\"notification\":{\"action\":\"notification\",\"data\":{\"title\":\"" + title + "\",\"message\":\"" + message + "\"}}}");
+        sendMessage("{\"notification\":{\"action\":\"notification\",\"data\":{\"title\":\"" + title + "\",\"message\":\"" + message + "\"}}}",
+                    TrafficClass::Social);
     }
 };
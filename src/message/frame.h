@@ -0,0 +1,32 @@
+#pragma once
+#include <cstdint>
+#include <cstddef>
+#include <string>
+
+// Khung tin nhắn trên stream:
+//  - Tin JSON cũ: văn bản kết thúc bằng '\n' (không bao giờ bắt đầu bằng byte 0x00)
+//  - Tin nhị phân: [0x00][độ dài payload u32 little-endian][payload]
+constexpr uint8_t kBinaryFrameMarker = 0x00;
+constexpr size_t kBinaryFrameHeaderSize = 5;
+
+// Byte mở đầu của stream client mở: kStreamPrefaceBase + lớp lưu lượng (TrafficClass),
+// gửi một lần trước tin đầu tiên. Stream không có byte này (client cũ) là stream Control
+// và khi là stream duy nhất thì chở mọi lớp.
+constexpr uint8_t kStreamPrefaceBase = 0xC0;
+constexpr uint8_t kStreamPrefaceMask = 0xFC;
+
+// Ghi header với độ dài tạm, trả về vị trí để vá lại bằng patchBinaryFrame
+inline size_t beginBinaryFrame(std::string &out)
+{
+    size_t pos = out.size();
+    out.append(kBinaryFrameHeaderSize, '\0');
+    out[pos] = static_cast<char>(kBinaryFrameMarker);
+    return pos;
+}
+
+inline void patchBinaryFrame(std::string &out, size_t pos)
+{
+    uint32_t len = static_cast<uint32_t>(out.size() - pos - kBinaryFrameHeaderSize);
+    for (int i = 0; i < 4; ++i)
+        out[pos + 1 + i] = static_cast<char>((len >> (8 * i)) & 0xFF);
+}
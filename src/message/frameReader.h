@@ -0,0 +1,157 @@
+#pragma once
+#include <algorithm>
+#include <cstdint>
+#include <cstddef>
+#include <cstring>
+#include <string>
+#include <string_view>
+#include "frame.h"
+
+// Giới hạn mặc định của một tin client gửi lên (JSON hoặc payload nhị phân)
+constexpr size_t kMaxInboundMessageSize = 64 * 1024;
+
+// Tách tin từ luồng byte của một stream theo khung trong frame.h: khung nhị phân
+// [0x00][u32 độ dài][payload] hoặc dòng JSON cũ kết thúc bằng '\n' (payload nhị phân
+// chứa được mọi byte, kể cả '\n'). Tin nằm trọn trong buffer nhận được đưa cho handler
+// dưới dạng view trỏ thẳng vào buffer đó, không chép; chỉ đoạn cuối chưa trọn mới được
+// chép sang carry_ và ghép nốt ở lần nhận sau. Vì vậy carry_ không bao giờ chứa quá một
+// tin, không cần xoá đầu chuỗi hay dò lại từ đầu: chi phí tuyến tính theo số byte nhận.
+//
+// Mỗi FrameReader chỉ được dùng bởi một luồng tại một thời điểm.
+class FrameReader
+{
+public:
+    explicit FrameReader(size_t maxMessage = kMaxInboundMessageSize)
+        : maxMessage_(maxMessage)
+    {
+    }
+
+    // Gọi onMessage(std::string_view) cho từng tin trọn vẹn (không gồm header/'\n', bỏ
+    // tin rỗng). View chỉ hợp lệ trong lúc gọi. Trả về false nếu gặp tin vượt giới hạn:
+    // luồng byte sau đó không còn tin được, nên đóng kết nối.
+    template <typename OnMessage>
+    bool feed(const uint8_t *data, size_t len, OnMessage &&onMessage)
+    {
+        const char *p = reinterpret_cast<const char *>(data);
+        const char *end = p + len;
+
+        // Ghép nốt tin dở từ lần trước
+        if (!carry_.empty())
+        {
+            if (!completeCarry(p, end, onMessage))
+                return false;
+            if (!carry_.empty())
+                return true; // vẫn chưa đủ, data đã được chép hết vào carry_
+        }
+
+        // Tin trọn trong data: đưa view thẳng vào buffer nhận
+        while (p < end)
+        {
+            size_t header = 0, payload = 0;
+            const ptrdiff_t found = frameAt(p, end, header, payload);
+            if (found < 0)
+                return false;
+            if (found == 0)
+            {
+                carry_.assign(p, end);
+                return true;
+            }
+            if (payload > 0)
+                onMessage(std::string_view(p + header, payload));
+            p += found;
+        }
+        return true;
+    }
+
+    // Đổi giới hạn một tin; chỉ gọi khi chưa có tin dở (stream mới)
+    void setMaxMessage(size_t maxMessage) { maxMessage_ = maxMessage; }
+
+    // Số byte đang giữ của tin chưa trọn
+    size_t buffered() const { return carry_.size(); }
+
+    // Bỏ phần tin dở để dùng lại cho stream khác (giữ capacity)
+    void reset() { carry_.clear(); }
+
+private:
+    // Tìm khung đầu tiên bắt đầu tại p. Trả về tổng số byte của khung (>0), 0 nếu chưa đủ
+    // dữ liệu, -1 nếu vượt giới hạn. header/payload là vị trí và độ dài phần nội dung.
+    ptrdiff_t frameAt(const char *p, const char *end, size_t &header, size_t &payload) const
+    {
+        const size_t avail = static_cast<size_t>(end - p);
+        if (static_cast<uint8_t>(p[0]) == kBinaryFrameMarker)
+        {
+            if (avail < kBinaryFrameHeaderSize)
+                return 0;
+            const uint32_t n = lengthAt(p);
+            if (n > maxMessage_)
+                return -1;
+            if (avail < kBinaryFrameHeaderSize + n)
+                return 0;
+            header = kBinaryFrameHeaderSize;
+            payload = n;
+            return static_cast<ptrdiff_t>(kBinaryFrameHeaderSize + n);
+        }
+
+        const void *nl = std::memchr(p, '\n', avail);
+        if (!nl)
+            return avail > maxMessage_ ? -1 : 0;
+        header = 0;
+        payload = static_cast<size_t>(static_cast<const char *>(nl) - p);
+        if (payload > maxMessage_)
+            return -1;
+        return static_cast<ptrdiff_t>(payload + 1);
+    }
+
+    static uint32_t lengthAt(const char *header)
+    {
+        uint32_t n = 0;
+        for (int i = 0; i < 4; ++i)
+            n |= static_cast<uint32_t>(static_cast<uint8_t>(header[1 + i])) << (8 * i);
+        return n;
+    }
+
+    // Chép từ data vào carry_ vừa đủ cho tin đang dở; giao tin nếu đã trọn
+    template <typename OnMessage>
+    bool completeCarry(const char *&p, const char *end, OnMessage &onMessage)
+    {
+        if (static_cast<uint8_t>(carry_[0]) == kBinaryFrameMarker)
+        {
+            if (carry_.size() < kBinaryFrameHeaderSize)
+            {
+                const size_t take = std::min<size_t>(kBinaryFrameHeaderSize - carry_.size(), end - p);
+                carry_.append(p, take);
+                p += take;
+                if (carry_.size() < kBinaryFrameHeaderSize)
+                    return true;
+            }
+            const uint32_t n = lengthAt(carry_.data());
+            if (n > maxMessage_)
+                return false;
+            const size_t total = kBinaryFrameHeaderSize + n;
+            const size_t take = std::min<size_t>(total - carry_.size(), end - p);
+            carry_.append(p, take);
+            p += take;
+            if (carry_.size() < total)
+                return true;
+            if (n > 0)
+                onMessage(std::string_view(carry_.data() + kBinaryFrameHeaderSize, n));
+        }
+        else
+        {
+            const void *nl = std::memchr(p, '\n', static_cast<size_t>(end - p));
+            const char *stop = nl ? static_cast<const char *>(nl) : end;
+            if (carry_.size() + static_cast<size_t>(stop - p) > maxMessage_)
+                return false;
+            carry_.append(p, stop);
+            p = nl ? stop + 1 : end;
+            if (!nl)
+                return true;
+            onMessage(std::string_view(carry_));
+        }
+        carry_.clear(); // giữ capacity cho lần sau
+        return true;
+    }
+
+    size_t maxMessage_;
+    std::string carry_;
+};
@@ -35,11 +35,11 @@ public:
             }
 
             // Không tìm thấy event hợp lệ
-            client.sendMessage("{\"auth\":{\"action\":\"error\",\"data\":{\"message\":\"Unauthorized or unknown action\"}}}");
+            client.sendMessage("{\"auth\":{\"action\":\"error\",\"data\":{\"message\":\"Unauthorized or unknown action\"}}}", TrafficClass::Control);
         }
         catch (const std::exception &e)
         {
-            client.sendMessage("{\"auth\":{\"action\":\"error\",\"data\":{\"message\":\"Invalid message format\"}}}");
+            client.sendMessage("{\"auth\":{\"action\":\"error\",\"data\":{\"message\":\"Invalid message format\"}}}", TrafficClass::Control);
         }
     }
 
@@ -26,11 +26,11 @@ public:
         {
             client.auth = true;
             client.playerId = data.value("playerId", "unknown");
-            client.sendMessage("{\"auth\":{\"action\":\"success\"}}");
+            client.sendMessage("{\"auth\":{\"action\":\"success\"}}", TrafficClass::Control);
         }
         else
         {
-            client.sendMessage("{\"auth\":{\"action\":\"error\",\"data\":{\"message\":\"Invalid token\"}}}");
+            client.sendMessage("{\"auth\":{\"action\":\"error\",\"data\":{\"message\":\"Invalid token\"}}}", TrafficClass::Control);
         }
     }
 
@@ -38,10 +38,10 @@ public:
     {
         if (!client.auth)
         {
-            client.sendMessage("{\"guild\":{\"action\":\"error\",\"data\":{\"message\":\"Unauthorized\"}}}");
+            client.sendMessage("{\"guild\":{\"action\":\"error\",\"data\":{\"message\":\"Unauthorized\"}}}", TrafficClass::Control);
             return;
         }
-        client.sendMessage("{\"guild\":{\"action\":\"success\",\"data\":\"Guild handled\"}}");
+        client.sendMessage("{\"guild\":{\"action\":\"success\",\"data\":\"Guild handled\"}}", TrafficClass::Bulk);
     }
 
     void HandleChat(ClientContext &client, const json &data)
@@ -49,7 +49,7 @@ public:
         if (!client.auth)
             return;
         // Xử lý chat message
-        client.sendMessage("{\"chat\":{\"action\":\"echo\",\"data\":\"" + data.dump() + "\"}}");
+        client.sendMessage("{\"chat\":{\"action\":\"echo\",\"data\":\"" + data.dump() + "\"}}", TrafficClass::Social);
     }
 
     // ... các handler khác
@@ -1,21 +1,54 @@
 #include "quicServer.h"
+#include <algorithm>
+#include <chrono>
 #include <iostream>
+#include <latch>
 #include <vector>
 #include <stdexcept>
 #include <cstring>
 #include "../core/gameplay.h"
+#include "../message/frame.h"
 
-static std::map<HQUIC, HQUIC> g_StreamToConnection;
-static std::mutex g_PlayersMutex;
-static std::mutex g_StreamToConnectionMutex;
-static std::map<HQUIC, Player> g_Players;
-quicServer::quicServer(const std::string &certPath, const std::string &keyPath, boost::asio::io_context &io)
+namespace
+{
+    // Độ ưu tiên msquic theo lớp lưu lượng (số lớn gửi trước, mặc định 0x7FFF): tin điều
+    // khiển và snapshot luôn đi trước chat, chat đi trước phản hồi lớn
+    constexpr uint16_t kStreamPriority[kTrafficClassCount] = {0xFFFF, 0xC000, 0x6000, 0x2000};
+
+    // Kết nối vượt giới hạn đầu vào chỉ được log lần đầu và sau mỗi chừng này lần
+    constexpr uint64_t kViolationLogEvery = 1000;
+
+    uint64_t steadyNowNs()
+    {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(
+                   std::chrono::steady_clock::now().time_since_epoch())
+            .count();
+    }
+}
+
+quicServer::quicServer(const std::string &certPath, const std::string &keyPath, IoContextPool &io)
     : certFile_(certPath), keyFile_(keyPath), io_(io), MsQuic(nullptr), Registration(nullptr), Configuration(nullptr), Listener(nullptr)
 {
     if (MsQuicOpen2(&MsQuic) != QUIC_STATUS_SUCCESS)
         throw std::runtime_error("Failed to open MsQuic");
 
-    QUIC_REGISTRATION_CONFIG regConfig{"quicServer", QUIC_EXECUTION_PROFILE_LOW_LATENCY};
+#ifdef QUIC_PARAM_GLOBAL_EXECUTION_CONFIG
+    // Đặt worker của msquic lên đúng các core mà pool io dùng, để gói của một kết nối
+    // được xử lý và đưa sang io_context trên cùng nhóm core. Phải đặt trước RegistrationOpen.
+    const std::vector<uint16_t> &cpus = io_.cpus();
+    std::vector<uint8_t> execBuffer(sizeof(QUIC_GLOBAL_EXECUTION_CONFIG) + cpus.size() * sizeof(uint16_t));
+    auto *execConfig = reinterpret_cast<QUIC_GLOBAL_EXECUTION_CONFIG *>(execBuffer.data());
+    execConfig->ProcessorCount = static_cast<uint32_t>(cpus.size());
+    std::memcpy(execConfig->ProcessorList, cpus.data(), cpus.size() * sizeof(uint16_t));
+    const uint32_t execSize = static_cast<uint32_t>(QUIC_GLOBAL_EXECUTION_CONFIG_MIN_SIZE + cpus.size() * sizeof(uint16_t));
+    if (QUIC_FAILED(MsQuic->SetParam(nullptr, QUIC_PARAM_GLOBAL_EXECUTION_CONFIG, execSize, execConfig)))
+        std::cerr << "[QUIC] Failed to set execution config, using msquic defaults\n";
+#endif
+
+    // Một io thread thì giữ độ trễ thấp; nhiều io thread thì để msquic chia kết nối ra nhiều
+    // worker (mỗi core một partition) cho thông lượng tăng theo số core
+    QUIC_REGISTRATION_CONFIG regConfig{"quicServer", io_.size() > 1 ? QUIC_EXECUTION_PROFILE_TYPE_MAX_THROUGHPUT
+                                                                    : QUIC_EXECUTION_PROFILE_LOW_LATENCY};
     if (MsQuic->RegistrationOpen(&regConfig, &Registration) != QUIC_STATUS_SUCCESS)
         throw std::runtime_error("Failed to open MsQuic Registration");
 }
@@ -46,14 +79,17 @@ bool quicServer::start(uint16_t port)
     Cert.PrivateKeyFile = keyFile_.c_str();
     CredConfig.CertificateFile = &Cert;
 
-    // --- Mở cấu hình QUIC trước ---
-    if (QUIC_FAILED(MsQuic->ConfigurationOpen(Registration, &Alpn, 1, nullptr, 0, nullptr, &Configuration)))
-        return false;
-
-    // --- Set QUIC settings sau khi có Configuration ---
+    // --- Mở cấu hình QUIC kèm settings ---
     QUIC_SETTINGS settings{};
     settings.IsSet.PeerBidiStreamCount = TRUE;
     settings.PeerBidiStreamCount = 10000;
+    // Nhận datagram từ client (lệnh di chuyển); client bật tương tự thì server gửi snapshot qua datagram
+    settings.IsSet.DatagramReceiveEnabled = TRUE;
+    settings.DatagramReceiveEnabled = TRUE;
+    // Cấp TLS session ticket và nhận 0-RTT: client nối lại (đổi mạng, rớt kết nối) gửi
+    // được join kèm token ngay trong gói đầu, không chờ bắt tay đầy đủ
+    settings.IsSet.ServerResumptionLevel = TRUE;
+    settings.ServerResumptionLevel = QUIC_SERVER_RESUME_AND_ZERORTT;
 
     if (QUIC_FAILED(MsQuic->ConfigurationOpen(
             Registration,
@@ -85,25 +121,65 @@ bool quicServer::start(uint16_t port)
 
 void quicServer::stop()
 {
-    // Đóng tất cả connections và streams
-    {
-        std::lock_guard<std::mutex> g(clients_mutex_);
-        for (auto &kv : clients_)
-        {
-            if (kv.second.Stream)
-                MsQuic->StreamClose(kv.second.Stream);
-            if (kv.second.Connection)
-                MsQuic->ConnectionClose(kv.second.Connection);
-        }
-        clients_.clear();
-    }
+    // Destructor gọi lại stop(): chỉ dọn một lần
+    if (stopped_.exchange(true))
+        return;
 
-    // Đóng listener và cấu hình
+    std::cout << "[QUIC] Datagrams sent=" << datagramsSent_.load() << " fallbacks to stream=" << datagramFallbacks_.load() << "\n";
+    std::cout << "[QUIC] StreamSend calls=" << streamSends_.load() << " coalesced msgs=" << coalescedMessages_.load()
+              << " coalesced bytes=" << coalescedBytes_.load() << "\n";
+    std::cout << "[QUIC] Backpressured flushes=" << backpressuredFlushes_.load()
+              << " dropped snapshots=" << droppedSnapshots_.load() << "\n";
+    std::cout << "[QUIC] Resumed connections=" << resumedConnections_.load() << "\n";
+    std::cout << "[QUIC] Ingress throttled msgs=" << throttledMessages_.load() << " bytes=" << throttledBytes_.load()
+              << " oversized frames=" << oversizedFrames_.load() << "\n";
+
+    // Đóng listener trước: không nhận kết nối mới trong lúc dọn
     if (Listener)
     {
         MsQuic->ListenerClose(Listener);
         Listener = nullptr;
     }
+
+    // Lấy các phiên ra khỏi bảng rồi mới đóng: ConnectionClose chờ SHUTDOWN_COMPLETE
+    // chạy xong (callback không được khoá lại bảng trong lúc này). Phiên đã rời bảng thì
+    // SHUTDOWN_COMPLETE không tự trả về pool nữa, stop() giữ quyền dọn.
+    std::vector<Session *> sessions;
+    {
+        std::unique_lock<std::shared_mutex> lk(sessions_mutex_);
+        for (auto &kv : sessions_)
+            sessions.push_back(kv.second);
+        sessions_.clear();
+    }
+
+    if (io_.running())
+    {
+        // Dọn trên io của từng kết nối, sau các gói nhận / StreamClose đã xếp hàng. Trả phiên
+        // về pool ở lượt post thứ hai: ConnectionClose trả về thì msquic không gọi callback
+        // của kết nối nữa, nên mọi việc callback kịp post đều nằm trước lượt này.
+        std::latch done(static_cast<std::ptrdiff_t>(sessions.size()));
+        for (Session *session : sessions)
+        {
+            boost::asio::post(*session->Io, [this, session, &done]()
+                              {
+                closeSession(*session);
+                boost::asio::post(*session->Io, [this, session, &done]()
+                                  {
+                    sessionPool_.release(session);
+                    done.count_down(); }); });
+        }
+        done.wait();
+    }
+    else
+    {
+        // Pool io đã dừng (hoặc chưa chạy): không còn việc nào chạy song song
+        for (Session *session : sessions)
+        {
+            closeSession(*session);
+            sessionPool_.release(session);
+        }
+    }
+
     if (Configuration)
     {
         MsQuic->ConfigurationClose(Configuration);
@@ -111,52 +187,317 @@ void quicServer::stop()
     }
 }
 
+void quicServer::closeSession(Session &session)
+{
+    // Nhận quyền đóng các stream còn mở: SHUTDOWN_COMPLETE thấy Handle rỗng thì không đóng lại
+    std::vector<HQUIC> streams;
+    {
+        std::lock_guard<std::mutex> sendLock(session.SendMutex);
+        for (SessionStream &stream : session.Streams)
+        {
+            if (stream.Handle)
+                streams.push_back(stream.Handle);
+            stream.Handle = nullptr;
+        }
+    }
+    session.Closed = true;
+    for (HQUIC stream : streams)
+        MsQuic->StreamClose(stream);
+    MsQuic->ConnectionClose(session.Connection);
+}
+
 bool quicServer::sendMessage(HQUIC stream, const std::string &msg)
+{
+    return sendMessage(stream, std::string(msg));
+}
+
+bool quicServer::sendMessage(HQUIC stream, std::string &&msg)
 {
     if (!stream)
         return false;
 
-    // Gói chung string + buffer vào 1 struct
-    struct SendContext
+    SendBuffer *buffer = SendBuffer::create(std::move(msg));
+    SendBatch *batch = SendBatch::create();
+    batch->add(buffer);
+    buffer->release(); // bỏ tham chiếu của người tạo, lô giữ tham chiếu riêng
+    return sendBatch(stream, batch);
+}
+
+bool quicServer::sendMessage(ConnectionId conn, std::string &&msg, TrafficClass cls)
+{
+    SendBuffer *buffer = SendBuffer::create(std::move(msg));
+    bool ok = enqueue(conn, buffer, cls);
+    buffer->release();
+    return ok;
+}
+
+size_t quicServer::broadcast(const std::vector<ConnectionId> &conns, std::string msg, TrafficClass cls)
+{
+    if (conns.empty())
+        return 0;
+
+    SendBuffer *buffer = SendBuffer::create(std::move(msg));
+    size_t queued = 0;
+    for (ConnectionId conn : conns)
     {
-        std::string data;
-        QUIC_BUFFER buf;
-    };
+        if (enqueue(conn, buffer, cls))
+            ++queued;
+    }
+    buffer->release();
+    return queued;
+}
+
+size_t quicServer::broadcastUnreliable(const std::vector<ConnectionId> &conns, std::string msg)
+{
+    if (conns.empty())
+        return 0;
+
+    SendBuffer *buffer = SendBuffer::create(std::move(msg));
+    size_t queued = 0;
+    for (ConnectionId conn : conns)
+    {
+        if (enqueue(conn, buffer, TrafficClass::Gameplay, true))
+            ++queued;
+    }
+    buffer->release();
+    return queued;
+}
+
+bool quicServer::enqueue(ConnectionId conn, SendBuffer *buffer, TrafficClass cls, bool superseding)
+{
+    bool queued = false;
+    withSession(conn, [&](Session &session)
+                {
+        SessionStream *stream = session.route(cls);
+        if (stream && stream->Handle)
+        {
+            enqueueLocked(session, *stream, buffer, superseding);
+            queued = true;
+        } });
+    return queued;
+}
+
+void quicServer::enqueueLocked(Session &session, SessionStream &stream, SendBuffer *buffer, bool superseding)
+{
+    if (!stream.Outbound)
+        stream.Outbound = SendBatch::create();
+    if (stream.Outbound->add(buffer, superseding))
+    {
+        // Snapshot cũ chưa kịp gửi (stream nghẽn): snapshot mới đã thay chỗ
+        session.DroppedSnapshots++;
+        droppedSnapshots_.fetch_add(1, std::memory_order_relaxed);
+    }
+}
+
+void quicServer::flush(const std::vector<ConnectionId> &conns)
+{
+    for (ConnectionId conn : conns)
+    {
+        // StreamSend chỉ xếp việc cho worker của msquic nên gọi ngay dưới khoá của phiên;
+        // nhờ vậy stream không thể bị đóng giữa chừng. Mỗi stream nghẽn độc lập: bulk
+        // không đọc kịp không giữ lại snapshot.
+        withSession(conn, [&](Session &session)
+                    {
+            for (SessionStream &stream : session.Streams)
+            {
+                if (!stream.Outbound || !stream.Handle)
+                    continue;
+                if (stream.InFlight >= stream.SendWindow)
+                {
+                    // Client không đọc kịp: giữ lô lại, snapshot trong lô sẽ bị snapshot sau thay
+                    backpressuredFlushes_.fetch_add(1, std::memory_order_relaxed);
+                    continue;
+                }
+                SendBatch *batch = stream.Outbound;
+                stream.Outbound = nullptr;
+                const uint64_t bytes = batch->bytes();
+                if (batch->count() > 1)
+                {
+                    coalescedMessages_.fetch_add(batch->count() - 1, std::memory_order_relaxed);
+                    coalescedBytes_.fetch_add(bytes, std::memory_order_relaxed);
+                }
+                if (sendBatch(stream.Handle, batch))
+                    stream.InFlight += bytes;
+            } });
+    }
+}
 
-    auto *ctx = new SendContext{msg, {}};
-    ctx->buf.Buffer = (uint8_t *)ctx->data.data();
-    ctx->buf.Length = static_cast<uint32_t>(ctx->data.size());
+quicServer::SendQueueStats quicServer::sendQueue(ConnectionId conn)
+{
+    SendQueueStats stats;
+    withSession(conn, [&](Session &session)
+                {
+        for (const SessionStream &stream : session.Streams)
+        {
+            if (stream.Outbound)
+            {
+                stats.queuedMessages += stream.Outbound->count();
+                stats.queuedBytes += stream.Outbound->bytes();
+            }
+            stats.inFlightBytes += stream.InFlight;
+        }
+        stats.droppedSnapshots = session.DroppedSnapshots; });
+    return stats;
+}
 
+bool quicServer::sendBatch(HQUIC stream, SendBatch *batch)
+{
+    // Lô được truyền qua ClientContext, trả lại khi SEND_COMPLETE về
     QUIC_STATUS status = MsQuic->StreamSend(
         stream,
-        &ctx->buf,
-        1,
+        batch->quicBuffers(),
+        batch->count(),
         QUIC_SEND_FLAG_NONE,
-        ctx // context giữ luôn cả string + buffer
-    );
+        batch);
 
     if (QUIC_FAILED(status))
     {
-        delete ctx;
+        batch->release();
         std::cerr << "[QUIC] StreamSend failed: 0x"
                   << std::hex << status << std::dec << "\n";
         return false;
     }
 
+    streamSends_.fetch_add(1, std::memory_order_relaxed);
     return true;
 }
 
-std::string &quicServer::recvBufferForStream(HQUIC stream)
+bool quicServer::sendUnreliable(ConnectionId conn, std::string &&msg)
 {
-    std::lock_guard<std::mutex> lk(recv_buffers_mutex_);
-    // tạo buffer nếu chưa tồn tại
-    return recv_buffers_[stream];
+    SendBuffer *buffer = SendBuffer::create(std::move(msg));
+    bool ok = false;
+    withSession(conn, [&](Session &session)
+                {
+        // Còn tin tin cậy chờ flush (ví dụ welcome) thì snapshot đi stream, cùng lần flush
+        if (session.DatagramMax > 0 && !session.hasOutbound() && buffer->size() <= session.DatagramMax)
+        {
+            // Tham chiếu riêng cho DatagramSend, trả lại ở DATAGRAM_SEND_STATE_CHANGED
+            buffer->addRef();
+            QUIC_STATUS status = MsQuic->DatagramSend(session.Connection, buffer->quicBuffer(), 1, QUIC_SEND_FLAG_NONE, buffer);
+            if (QUIC_SUCCEEDED(status))
+            {
+                datagramsSent_.fetch_add(1, std::memory_order_relaxed);
+                ok = true;
+                return;
+            }
+            buffer->release();
+        }
+
+        // Không vừa datagram, còn tin chờ hoặc DatagramSend lỗi (ví dụ MTU vừa giảm): đi theo stream
+        if (session.DatagramMax > 0)
+            datagramFallbacks_.fetch_add(1, std::memory_order_relaxed);
+        SessionStream *stream = session.route(TrafficClass::Gameplay);
+        if (stream && stream->Handle)
+        {
+            enqueueLocked(session, *stream, buffer, true);
+            ok = true;
+        } });
+    buffer->release();
+    return ok;
 }
+
+size_t quicServer::maxDatagramSize(ConnectionId conn)
+{
+    size_t max = 0;
+    withSession(conn, [&](Session &session)
+                { max = session.DatagramMax; });
+    return max;
+}
+
+uint32_t quicServer::roundTripMicros(ConnectionId conn)
+{
+    std::shared_lock<std::shared_mutex> lk(sessions_mutex_);
+    auto it = sessions_.find(conn);
+    return it != sessions_.end() ? it->second->RttMicros.load(std::memory_order_relaxed) : 0;
+}
+
+void quicServer::disconnect(ConnectionId conn)
+{
+    // SHUTDOWN_COMPLETE sẽ dọn dẹp và báo onDisconnected
+    std::shared_lock<std::shared_mutex> lk(sessions_mutex_);
+    auto it = sessions_.find(conn);
+    if (it != sessions_.end())
+        MsQuic->ConnectionShutdown(it->second->Connection, QUIC_CONNECTION_SHUTDOWN_FLAG_NONE, 0);
+}
+
 void quicServer::handleSendComplete(void *client_context)
 {
     if (!client_context)
         return;
-    delete reinterpret_cast<std::string *>(client_context);
+    static_cast<SendBuffer *>(client_context)->release();
+}
+
+void quicServer::classifyStream(SessionStream &stream, std::vector<QUIC_BUFFER> &buffers)
+{
+    // Byte đầu tiên của stream: byte mở đầu thì bỏ đi và ghi nhận lớp, còn lại là client cũ
+    for (QUIC_BUFFER &buf : buffers)
+    {
+        if (buf.Length == 0)
+            continue;
+        if ((buf.Buffer[0] & kStreamPrefaceMask) == kStreamPrefaceBase)
+        {
+            stream.Class = static_cast<TrafficClass>(buf.Buffer[0] & ~kStreamPrefaceMask);
+            ++buf.Buffer;
+            --buf.Length;
+        }
+        stream.Classified = true;
+        break;
+    }
+    if (!stream.Classified)
+        return;
+
+    Session &session = *stream.Owner;
+    {
+        std::lock_guard<std::mutex> sendLock(session.SendMutex);
+        session.Route[static_cast<size_t>(stream.Class)] = &stream;
+    }
+    uint16_t priority = kStreamPriority[static_cast<size_t>(stream.Class)];
+    MsQuic->SetParam(stream.Handle, QUIC_PARAM_STREAM_PRIORITY, sizeof(priority), &priority);
+}
+
+void quicServer::handleReceive(SessionStream *stream, HQUIC handle, const std::vector<QUIC_BUFFER> &buffers, uint64_t total)
+{
+    Session *session = stream->Owner;
+    // Handle đã bị stop() đóng trước khi lần nhận này tới lượt
+    if (session->Closed)
+        return;
+    const uint64_t nowNs = steadyNowNs();
+    auto deliver = [this, session, nowNs](std::string_view msg)
+    {
+        // Bỏ tin vượt hạn mức trước khi tới gameplay (chưa giải mã gì)
+        if (onMessage && admit(*session, msg.size(), nowNs))
+            onMessage(session->Id, msg);
+    };
+    for (const QUIC_BUFFER &buf : buffers)
+    {
+        if (!stream->Reader.feed(buf.Buffer, buf.Length, deliver))
+        {
+            // Tin vượt giới hạn: không tách tiếp được luồng byte này
+            oversizedFrames_.fetch_add(1, std::memory_order_relaxed);
+            std::cout << "[QUIC] Oversized message from connection " << session->Id << ", closing\n";
+            MsQuic->ConnectionShutdown(session->Connection, QUIC_CONNECTION_SHUTDOWN_FLAG_NONE, 0);
+            break;
+        }
+    }
+    // Dùng handle chép lúc RECEIVE: SHUTDOWN_COMPLETE có thể đã xoá stream->Handle trên worker,
+    // còn handle vẫn sống tới khi lambda StreamClose (post sau lần nhận này) chạy
+    MsQuic->StreamReceiveComplete(handle, total);
+}
+
+bool quicServer::admit(Session &session, size_t bytes, uint64_t nowNs)
+{
+    const double n = static_cast<double>(bytes);
+    if (session.MessageBudget.available(1, nowNs) && session.ByteBudget.available(n, nowNs))
+    {
+        session.MessageBudget.consume(1);
+        session.ByteBudget.consume(n);
+        return true;
+    }
+    throttledMessages_.fetch_add(1, std::memory_order_relaxed);
+    throttledBytes_.fetch_add(bytes, std::memory_order_relaxed);
+    if (session.IngressViolations++ % kViolationLogEvery == 0)
+        std::cout << "[QUIC] Connection " << session.Id << " over ingress limit, dropped " << session.IngressViolations << " msgs\n";
+    return false;
 }
 
 // ---------- static callbacks ----------
@@ -166,11 +507,19 @@ QUIC_STATUS QUIC_API quicServer::listenerCallback(HQUIC, void *ctx, QUIC_LISTENE
     if (evt->Type == QUIC_LISTENER_EVENT_NEW_CONNECTION)
     {
         HQUIC conn = evt->NEW_CONNECTION.Connection;
+        Session *session = self->sessionPool_.acquire();
+        session->Server = self;
+        session->Connection = conn;
+        session->MessageBudget.configure(self->ingress_.messagesPerSec, self->ingress_.messageBurst);
+        session->ByteBudget.configure(self->ingress_.bytesPerSec, self->ingress_.byteBurst);
         {
-            std::lock_guard<std::mutex> lk(self->clients_mutex_);
-            self->clients_[conn] = {conn, nullptr};
+            std::unique_lock<std::shared_mutex> lk(self->sessions_mutex_);
+            session->Id = self->nextConnectionId_++;
+            self->sessions_[session->Id] = session;
         }
-        self->MsQuic->SetCallbackHandler(conn, (void *)connectionCallback, self);
+        session->Io = &self->io_.forKey(session->Id);
+        // Từ đây mọi sự kiện của kết nối mang theo chính Session làm context
+        self->MsQuic->SetCallbackHandler(conn, (void *)connectionCallback, session);
         self->MsQuic->ConnectionSetConfiguration(conn, self->Configuration);
     }
     return QUIC_STATUS_SUCCESS;
@@ -178,60 +527,128 @@ QUIC_STATUS QUIC_API quicServer::listenerCallback(HQUIC, void *ctx, QUIC_LISTENE
 
 QUIC_STATUS QUIC_API quicServer::connectionCallback(HQUIC conn, void *ctx, QUIC_CONNECTION_EVENT *evt)
 {
-    auto *self = static_cast<quicServer *>(ctx);
-    std::cout << evt->Type << "\n";
+    auto *session = static_cast<Session *>(ctx);
+    quicServer *self = session->Server;
     switch (evt->Type)
     {
     case QUIC_CONNECTION_EVENT_CONNECTED:
     {
-        std::cout << "[QUIC] Client connected\n";
+        std::cout << "[QUIC] Client connected" << (evt->CONNECTED.SessionResumed ? " (resumed)" : "") << "\n";
+        if (evt->CONNECTED.SessionResumed)
+            self->resumedConnections_.fetch_add(1, std::memory_order_relaxed);
+        // Gửi ticket cho lần nối lại sau; token giữ người chơi nằm trong welcome của Gameplay
+        self->MsQuic->ConnectionSendResumptionTicket(conn, QUIC_SEND_RESUMPTION_FLAG_NONE, 0, nullptr);
         // KHÔNG mở stream chủ động từ server
         break;
     }
     case QUIC_CONNECTION_EVENT_PEER_STREAM_STARTED:
     {
         std::cout << "[QUIC] PEER_STREAM_STARTED\n";
-        HQUIC stream = evt->PEER_STREAM_STARTED.Stream;
+        HQUIC handle = evt->PEER_STREAM_STARTED.Stream;
+
+        // Lấy một ô trống; ô chỉ được trả lại trên io của kết nối sau khi stream cũ đóng hẳn
+        SessionStream *stream = nullptr;
+        for (SessionStream &slot : session->Streams)
+        {
+            if (!slot.InUse.exchange(true, std::memory_order_acq_rel))
+            {
+                stream = &slot;
+                break;
+            }
+        }
+        if (!stream)
+        {
+            // Quá số stream cho phép (mỗi lớp một stream): từ chối
+            self->MsQuic->SetCallbackHandler(handle, (void *)rejectedStreamCallback, self);
+            self->MsQuic->StreamShutdown(handle, QUIC_STREAM_SHUTDOWN_FLAG_ABORT, 0);
+            break;
+        }
+
+        // Ô vừa được io trả về (chưa có nhận nào đang chờ) nên đặt giới hạn ở đây được
+        stream->Reader.setMaxMessage(self->ingress_.maxFrameBytes);
+
+        bool first = false;
         {
-            std::lock_guard<std::mutex> lk(self->clients_mutex_);
-            auto it = self->clients_.find(conn);
-            if (it != self->clients_.end())
+            std::lock_guard<std::mutex> sendLock(session->SendMutex);
+            stream->Handle = handle;
+            if (!session->Primary)
             {
-                it->second.Stream = stream;
+                session->Primary = stream;
+                first = true;
             }
         }
-        self->MsQuic->SetCallbackHandler(stream, (void *)streamCallback, self);
-        self->MsQuic->StreamReceiveSetEnabled(stream, TRUE);
+        self->MsQuic->SetCallbackHandler(handle, (void *)streamCallback, stream);
+        self->MsQuic->StreamReceiveSetEnabled(handle, TRUE);
 
-        if (self->onStreamStarted)
+        if (first && self->onConnected)
         {
-            boost::asio::post(self->io_, [cb = self->onStreamStarted, conn, stream]()
-                              { cb(conn, stream); });
+            boost::asio::post(*session->Io, [self, id = session->Id]()
+                              { self->onConnected(id); });
         }
         break;
     }
-    case QUIC_CONNECTION_EVENT_SHUTDOWN_COMPLETE:
+    case QUIC_CONNECTION_EVENT_DATAGRAM_STATE_CHANGED:
+    {
+        // Client bật/tắt nhận datagram hoặc MTU đường truyền thay đổi
+        const uint16_t max = evt->DATAGRAM_STATE_CHANGED.SendEnabled ? evt->DATAGRAM_STATE_CHANGED.MaxSendLength : 0;
+        std::lock_guard<std::mutex> sendLock(session->SendMutex);
+        session->DatagramMax = max;
+        break;
+    }
+    case QUIC_CONNECTION_EVENT_DATAGRAM_RECEIVED:
     {
-        HQUIC stream_to_remove = nullptr;
+        const QUIC_BUFFER *buf = evt->DATAGRAM_RECEIVED.Buffer;
+        if (!buf || buf->Length == 0 || !self->onMessage)
+            break;
+        if (buf->Length > self->ingress_.maxFrameBytes)
         {
-            std::lock_guard<std::mutex> lk(self->clients_mutex_);
-            std::cout << "QUIC_CONNECTION_EVENT_SHUTDOWN_COMPLETE\n";
-            auto it = self->clients_.find(conn);
-            if (it != self->clients_.end())
-            {
-                stream_to_remove = it->second.Stream;
-                self->clients_.erase(it);
-            }
+            self->oversizedFrames_.fetch_add(1, std::memory_order_relaxed);
+            break;
         }
-        if (stream_to_remove)
+
+        // Mỗi datagram là một tin trọn vẹn; bỏ '\n' cuối nếu client gửi cùng định dạng stream
+        std::string msg(reinterpret_cast<const char *>(buf->Buffer), buf->Length);
+        if (msg.back() == '\n')
+            msg.pop_back();
+        if (!msg.empty())
         {
-            boost::asio::post(self->io_, [self, stream_to_remove]()
+            boost::asio::post(*session->Io, [self, session, msg = std::move(msg)]()
                               {
-                if (self->onClientDisconnected) {
-                    self->onClientDisconnected(stream_to_remove);
-                } });
+                if (!session->Closed && self->admit(*session, msg.size(), steadyNowNs()))
+                    self->onMessage(session->Id, msg); });
+        }
+        break;
+    }
+    case QUIC_CONNECTION_EVENT_DATAGRAM_SEND_STATE_CHANGED:
+    {
+        // Đã ack, mất hẳn hoặc bị huỷ: msquic không còn dùng buffer
+        if (QUIC_DATAGRAM_SEND_STATE_IS_FINAL(evt->DATAGRAM_SEND_STATE_CHANGED.State))
+            self->handleSendComplete(evt->DATAGRAM_SEND_STATE_CHANGED.ClientContext);
+        break;
+    }
+    case QUIC_CONNECTION_EVENT_SHUTDOWN_COMPLETE:
+    {
+        // stop() đang đóng kết nối và tự trả phiên về pool
+        if (evt->SHUTDOWN_COMPLETE.AppCloseInProgress)
+            break;
+
+        // Gỡ khỏi bảng trước: sau khoá này không luồng gameplay nào còn giữ phiên. Phiên
+        // không còn trong bảng nghĩa là stop() đã lấy nó và sẽ tự đóng, trả về pool.
+        {
+            std::unique_lock<std::shared_mutex> lk(self->sessions_mutex_);
+            if (self->sessions_.erase(session->Id) == 0)
+                break;
         }
         std::cout << "[QUIC] Connection shutdown\n";
+
+        // Post sau các gói nhận còn chờ trên io của kết nối (xử lý tuần tự) rồi mới đóng handle và
+        // trả phiên về pool
+        boost::asio::post(*session->Io, [self, session, conn]()
+                          {
+            if (self->onDisconnected)
+                self->onDisconnected(session->Id);
+            self->MsQuic->ConnectionClose(conn);
+            self->sessionPool_.release(session); });
         break;
     }
     default:
@@ -240,42 +657,89 @@ QUIC_STATUS QUIC_API quicServer::connectionCallback(HQUIC conn, void *ctx, QUIC_
     return QUIC_STATUS_SUCCESS;
 }
 
-QUIC_STATUS QUIC_API quicServer::streamCallback(HQUIC stream, void *ctx, QUIC_STREAM_EVENT *evt)
+QUIC_STATUS QUIC_API quicServer::streamCallback(HQUIC handle, void *ctx, QUIC_STREAM_EVENT *evt)
 {
-    auto *self = static_cast<quicServer *>(ctx);
+    auto *stream = static_cast<SessionStream *>(ctx);
+    Session *session = stream->Owner;
+    quicServer *self = session->Server;
 
     switch (evt->Type)
     {
     case QUIC_STREAM_EVENT_RECEIVE:
     {
-        for (uint32_t i = 0; i < evt->RECEIVE.BufferCount; ++i)
+        // Đang ở worker của kết nối nên GetParam chạy ngay, không phải chờ: cập nhật RTT
+        // mỗi lần nhận để gameplay đọc được giá trị mới khi xử lý lệnh bắn
+        QUIC_STATISTICS_V2 stats{};
+        uint32_t statsSize = sizeof(stats);
+        if (QUIC_SUCCEEDED(self->MsQuic->GetParam(session->Connection, QUIC_PARAM_CONN_STATISTICS_V2, &statsSize, &stats)))
+            session->RttMicros.store(stats.Rtt, std::memory_order_relaxed);
+
+        // Không chép dữ liệu: trả QUIC_STATUS_PENDING để msquic giữ các buffer tới khi
+        // io của kết nối tách tin xong và gọi StreamReceiveComplete. Trong lúc đó msquic không giao
+        // RECEIVE mới cho stream này nên thứ tự byte được giữ nguyên.
+        std::vector<QUIC_BUFFER> buffers(evt->RECEIVE.Buffers, evt->RECEIVE.Buffers + evt->RECEIVE.BufferCount);
+        if (!stream->Classified)
+            self->classifyStream(*stream, buffers);
+        const uint64_t total = evt->RECEIVE.TotalBufferLength;
+        boost::asio::post(*session->Io, [self, stream, handle, buffers = std::move(buffers), total]()
+                          { self->handleReceive(stream, handle, buffers, total); });
+        return QUIC_STATUS_PENDING;
+    }
+    case QUIC_STREAM_EVENT_SEND_COMPLETE:
+    {
+        // giải phóng cả lô đã gửi xong (hoặc bị huỷ) và trả lại phần byte đang bay
+        auto *batch = static_cast<SendBatch *>(evt->SEND_COMPLETE.ClientContext);
+        if (!batch)
+            break;
         {
-            auto data = std::make_shared<std::string>(
-                (char *)evt->RECEIVE.Buffers[i].Buffer,
-                evt->RECEIVE.Buffers[i].Length);
-            boost::asio::post(self->io_, [self, stream, data]()
-                              {
-            std::string &buf = self->recvBufferForStream(stream);
-            buf.append(*data);
-            size_t pos;
-            while ((pos = buf.find('\n')) != std::string::npos) {
-                std::string oneMsg = buf.substr(0, pos);
-                buf.erase(0, pos + 1);
-                if (!oneMsg.empty() && self->onMessageReceived) {
-                    self->onMessageReceived(stream, oneMsg);
-                }
-            } });
+            std::lock_guard<std::mutex> sendLock(session->SendMutex);
+            stream->InFlight -= std::min<uint64_t>(stream->InFlight, batch->bytes());
         }
+        batch->release();
         break;
     }
-    case QUIC_STREAM_EVENT_SEND_COMPLETE:
+    case QUIC_STREAM_EVENT_IDEAL_SEND_BUFFER_SIZE:
     {
-        // giải phóng dữ liệu send xong
-        self->handleSendComplete(evt->SEND_COMPLETE.ClientContext);
+        // msquic báo lượng byte chờ gửi vừa đủ lấp đường truyền (theo BDP ước lượng)
+        std::lock_guard<std::mutex> sendLock(session->SendMutex);
+        stream->SendWindow = std::max<uint64_t>(evt->IDEAL_SEND_BUFFER_SIZE.ByteCount, 1);
         break;
     }
-    case QUIC_STREAM_EVENT_PEER_SEND_SHUTDOWN:
     case QUIC_STREAM_EVENT_SHUTDOWN_COMPLETE:
+    {
+        if (evt->SHUTDOWN_COMPLETE.AppCloseInProgress)
+            break;
+        {
+            // Luồng gameplay không gửi thêm trên stream này nữa; lớp của nó quay về stream dự phòng
+            std::lock_guard<std::mutex> sendLock(session->SendMutex);
+            // Handle rỗng: stop() đã nhận quyền đóng stream này
+            if (!stream->Handle)
+                break;
+            stream->Handle = nullptr;
+            if (stream->Outbound)
+                stream->Outbound->release();
+            stream->Outbound = nullptr;
+            for (SessionStream *&route : session->Route)
+            {
+                if (route == stream)
+                    route = nullptr;
+            }
+            if (session->Primary == stream)
+                session->Primary = nullptr;
+        }
+        // Đóng sau các gói nhận còn chờ trên io của kết nối (chúng còn gọi StreamReceiveComplete) rồi
+        // mới trả ô cho stream khác
+        boost::asio::post(*session->Io, [self, stream, handle]()
+                          {
+            self->MsQuic->StreamClose(handle);
+            {
+                std::lock_guard<std::mutex> sendLock(stream->Owner->SendMutex);
+                stream->reset();
+            }
+            stream->InUse.store(false, std::memory_order_release); });
+        break;
+    }
+    case QUIC_STREAM_EVENT_PEER_SEND_SHUTDOWN:
         // Xử lý nếu cần
         break;
     default:
@@ -283,4 +747,12 @@ QUIC_STATUS QUIC_API quicServer::streamCallback(HQUIC stream, void *ctx, QUIC_ST
     }
 
     return QUIC_STATUS_SUCCESS;
-}
\ No newline at end of file
+}
+
+QUIC_STATUS QUIC_API quicServer::rejectedStreamCallback(HQUIC handle, void *ctx, QUIC_STREAM_EVENT *evt)
+{
+    // Stream bị từ chối: bỏ mọi dữ liệu, đóng handle khi stream kết thúc
+    if (evt->Type == QUIC_STREAM_EVENT_SHUTDOWN_COMPLETE && !evt->SHUTDOWN_COMPLETE.AppCloseInProgress)
+        static_cast<quicServer *>(ctx)->MsQuic->StreamClose(handle);
+    return QUIC_STATUS_SUCCESS;
+}
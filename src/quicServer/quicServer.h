@@ -3,46 +3,91 @@
 
 #include <msquic.h>
 #include <string>
-#include <map>
+#include <unordered_map>
 #include <mutex>
+#include <shared_mutex>
+#include <atomic>
 #include <functional>
+#include <vector>
 #include <boost/asio.hpp>
+#include "sendBuffer.h"
+#include "session.h"
+#include "../AsioService/IoContextPool.h"
+#include "../transport/transport.h"
 
 // Định nghĩa HQUIC dưới dạng một kiểu dữ liệu có thể dễ dàng sử dụng
 using HQUIC = QUIC_HANDLE *;
 
 class Gameplay;
-class quicServer
+class quicServer : public Transport
 {
 public:
-    // Cấu trúc để lưu trữ thông tin client
-    struct Client
-    {
-        HQUIC Connection;
-        HQUIC Stream;
-    };
-
-    quicServer(const std::string &certPath, const std::string &keyPath, boost::asio::io_context &io);
+    // Mỗi kết nối được gắn vào một io_context của pool (theo hash ConnectionId); profile
+    // thực thi và các core của msquic được chọn theo pool
+    quicServer(const std::string &certPath, const std::string &keyPath, IoContextPool &io);
     ~quicServer();
     // Khởi động server trên một cổng cụ thể
     bool start(uint16_t port);
 
-    // Dừng server và dọn dẹp tài nguyên
+    // Dừng server và dọn dẹp tài nguyên. Gọi trước khi dừng pool io: mỗi kết nối được
+    // đóng trên io của nó, sau các việc đã xếp hàng. Gọi nhiều lần chỉ dọn một lần.
     void stop();
 
-    // Gửi tin nhắn đến một stream cụ thể
+    // Giới hạn đầu vào của mỗi kết nối. Tin vượt token bucket (theo số tin hoặc số byte)
+    // bị bỏ trước khi tới onMessage, tức trước mọi lần giải mã JSON; tin trên stream lớn
+    // hơn maxFrameBytes làm đóng kết nối (không tách tiếp được luồng byte), datagram lớn
+    // hơn thì bị bỏ. rate <= 0 là không giới hạn.
+    struct IngressLimits
+    {
+        double messagesPerSec = 60;
+        double messageBurst = 120;
+        double bytesPerSec = 16 * 1024;
+        double byteBurst = 32 * 1024;
+        size_t maxFrameBytes = 4096;
+    };
+    // Gọi trước start()
+    void setIngressLimits(const IngressLimits &limits) { ingress_ = limits; }
+
+    // Gửi tin nhắn đến một stream cụ thể, ngay lập tức (không qua hàng đợi)
     bool sendMessage(HQUIC stream, const std::string &msg);
+    bool sendMessage(HQUIC stream, std::string &&msg);
+
+    // Transport: mỗi kết nối nhận một ConnectionId. Client mở tối đa một stream cho mỗi
+    // lớp lưu lượng (byte mở đầu trong frame.h); tin đi trên stream của lớp mình, lớp chưa
+    // có stream thì đi stream Control hoặc stream đầu tiên. Stream được đặt độ ưu tiên
+    // msquic theo lớp. Sự kiện onConnected/onMessage/onDisconnected được post vào
+    // io_context của kết nối trong pool (tuần tự theo từng kết nối, song song giữa các kết nối). Tin gửi theo ConnectionId xếp vào hàng đợi của stream
+    // và chỉ thực sự gửi khi flush.
+    bool sendMessage(ConnectionId conn, std::string &&msg, TrafficClass cls = TrafficClass::Control) override;
+
+    // Gửi cùng một tin nhắn đến nhiều stream: dữ liệu chỉ cấp phát một lần và
+    // được chia sẻ (đếm tham chiếu) giữa các hàng đợi. Trả về số stream nhận tin.
+    size_t broadcast(const std::vector<ConnectionId> &conns, std::string msg,
+                     TrafficClass cls = TrafficClass::Control) override;
+
+    // Snapshot dùng chung luôn đi stream (snapshot đầy đủ hiếm khi vừa một datagram)
+    // nhưng vẫn được thay bằng snapshot mới hơn khi stream nghẽn
+    size_t broadcastUnreliable(const std::vector<ConnectionId> &conns, std::string msg) override;
 
-    // Các callbacks để xử lý sự kiện
-    std::function<void(HQUIC, HQUIC)> onStreamStarted;
-    std::function<void(HQUIC)> onClientDisconnected;
-    std::function<void(HQUIC, const std::string &)> onMessageReceived;
-    std::function<void(HQUIC conn, HQUIC stream)> onClientConnected;
+    // Mỗi stream có tin chờ được gửi bằng đúng một StreamSend nhiều buffer, trừ stream
+    // còn nhiều byte chưa gửi xong hơn SendWindow: tin của nó đợi lần flush sau
+    void flush(const std::vector<ConnectionId> &conns) override;
+    SendQueueStats sendQueue(ConnectionId conn) override;
+
+    void disconnect(ConnectionId conn) override;
+
+    // RTT lấy từ thống kê kết nối của msquic, cập nhật mỗi lần nhận dữ liệu
+    uint32_t roundTripMicros(ConnectionId conn) override;
+
+    // Snapshot đi qua QUIC DATAGRAM khi client đã bật nhận datagram (server luôn bật
+    // DatagramReceiveEnabled nên client cũng gửi được lệnh di chuyển qua datagram)
+    bool sendUnreliable(ConnectionId conn, std::string &&msg) override;
+    size_t maxDatagramSize(ConnectionId conn) override;
 
 private:
     const std::string certFile_;
     const std::string keyFile_;
-    boost::asio::io_context &io_;
+    IoContextPool &io_;
 
     // MsQuic và các đối tượng liên quan
     const QUIC_API_TABLE *MsQuic;
@@ -50,22 +95,65 @@ private:
     HQUIC Configuration;
     HQUIC Listener;
 
-    // Quản lý các clients đã kết nối
-    std::map<HQUIC, Client> clients_;
-    std::mutex clients_mutex_;
+    // Phiên của các kết nối đang mở. Callback của msquic dùng thẳng Session qua context;
+    // bảng này chỉ để Transport API tra theo ConnectionId (đọc nhiều, ghi khi kết nối/đóng).
+    SessionPool sessionPool_;
+    std::unordered_map<ConnectionId, Session *> sessions_;
+    ConnectionId nextConnectionId_ = 1;
+    std::shared_mutex sessions_mutex_;
+
+    // Đếm datagram đã gửi và số tin phải chuyển sang stream (không hỗ trợ / quá lớn / lỗi)
+    std::atomic<uint64_t> datagramsSent_{0};
+    std::atomic<uint64_t> datagramFallbacks_{0};
+
+    // Đếm StreamSend và phần được gom: tin/byte đi chung StreamSend với tin khác
+    std::atomic<uint64_t> streamSends_{0};
+    std::atomic<uint64_t> coalescedMessages_{0};
+    std::atomic<uint64_t> coalescedBytes_{0};
+    // Lần flush bị hoãn vì stream nghẽn và snapshot bị thay trước khi kịp gửi
+    std::atomic<uint64_t> backpressuredFlushes_{0};
+    std::atomic<uint64_t> droppedSnapshots_{0};
+    // Kết nối bắt tay lại bằng session ticket (có thể kèm 0-RTT)
+    std::atomic<uint64_t> resumedConnections_{0};
+
+    // Kiểm soát đầu vào: tin/byte bị bỏ vì vượt token bucket, tin vượt maxFrameBytes
+    IngressLimits ingress_;
+    std::atomic<uint64_t> throttledMessages_{0};
+    std::atomic<uint64_t> throttledBytes_{0};
+    std::atomic<uint64_t> oversizedFrames_{0};
+
+    std::atomic<bool> stopped_{false};
 
-    // Buffer để xử lý dữ liệu nhận được
-    std::map<HQUIC, std::string> recv_buffers_;
-    std::mutex recv_buffers_mutex_;
     Gameplay *gameplay_ = nullptr;
     // Hàm callback tĩnh được gọi bởi MsQuic
     static QUIC_STATUS QUIC_API listenerCallback(HQUIC Listener, void *ctx, QUIC_LISTENER_EVENT *evt);
     static QUIC_STATUS QUIC_API connectionCallback(HQUIC Connection, void *ctx, QUIC_CONNECTION_EVENT *evt);
     static QUIC_STATUS QUIC_API streamCallback(HQUIC Stream, void *ctx, QUIC_STREAM_EVENT *evt);
+    static QUIC_STATUS QUIC_API rejectedStreamCallback(HQUIC Stream, void *ctx, QUIC_STREAM_EVENT *evt);
 
     // Hàm hỗ trợ
+    bool sendBatch(HQUIC stream, SendBatch *batch);
+    bool enqueue(ConnectionId conn, SendBuffer *buffer, TrafficClass cls, bool superseding = false);
+    void enqueueLocked(Session &session, SessionStream &stream, SendBuffer *buffer, bool superseding);
     void handleSendComplete(void *client_context);
-    std::string &recvBufferForStream(HQUIC stream);
+    void classifyStream(SessionStream &stream, std::vector<QUIC_BUFFER> &buffers);
+    void handleReceive(SessionStream *stream, HQUIC handle, const std::vector<QUIC_BUFFER> &buffers, uint64_t total);
+    bool admit(Session &session, size_t bytes, uint64_t nowNs);
+    void closeSession(Session &session);
+
+    // Gọi f(Session &) dưới khoá đọc của bảng phiên và khoá gửi của phiên; false nếu
+    // kết nối không còn
+    template <typename F>
+    bool withSession(ConnectionId conn, F &&f)
+    {
+        std::shared_lock<std::shared_mutex> lk(sessions_mutex_);
+        auto it = sessions_.find(conn);
+        if (it == sessions_.end())
+            return false;
+        std::lock_guard<std::mutex> sendLock(it->second->SendMutex);
+        f(*it->second);
+        return true;
+    }
 };
 
 #endif // QUIC_SERVER_H
\ No newline at end of file
@@ -0,0 +1,105 @@
+#pragma once
+#include <msquic.h>
+#include <atomic>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Buffer gửi bất biến có đếm tham chiếu. Một tin nhắn chỉ cấp phát và sao chép một lần,
+// rồi cùng QUIC_BUFFER được đưa cho hàng đợi của mọi stream nhận; mỗi SendBatch chứa
+// nó giữ một tham chiếu và trả lại khi QUIC_STREAM_EVENT_SEND_COMPLETE về.
+// DatagramSend cũng vậy, trả lại khi trạng thái gửi datagram là trạng thái cuối.
+class SendBuffer
+{
+public:
+    // Tạo buffer với một tham chiếu thuộc về người gọi
+    static SendBuffer *create(std::string data)
+    {
+        return new SendBuffer(std::move(data));
+    }
+
+    void addRef()
+    {
+        refs_.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    void release()
+    {
+        if (refs_.fetch_sub(1, std::memory_order_acq_rel) == 1)
+            delete this;
+    }
+
+    const QUIC_BUFFER *quicBuffer() const { return &buf_; }
+    uint32_t size() const { return buf_.Length; }
+
+private:
+    explicit SendBuffer(std::string data)
+        : data_(std::move(data))
+    {
+        buf_.Buffer = reinterpret_cast<uint8_t *>(data_.data());
+        buf_.Length = static_cast<uint32_t>(data_.size());
+    }
+    ~SendBuffer() = default;
+
+    std::atomic<uint32_t> refs_{1};
+    std::string data_;
+    QUIC_BUFFER buf_{};
+};
+
+// Các tin của một stream gom lại trong một tick (hoặc lâu hơn khi stream đang nghẽn) rồi
+// gửi bằng một StreamSend nhiều buffer.
+// Lô giữ một tham chiếu tới từng SendBuffer cùng mảng QUIC_BUFFER (msquic đọc tới khi
+// gửi xong) và được truyền qua ClientContext; SEND_COMPLETE trả lại tất cả một lượt.
+class SendBatch
+{
+public:
+    static SendBatch *create()
+    {
+        return new SendBatch();
+    }
+
+    // Thêm tin vào cuối lô, lô giữ tham chiếu riêng. Tin superseding (snapshot) thay tin
+    // superseding cũ hơn còn trong lô; trả về true nếu đã thay (tin cũ bị bỏ).
+    bool add(SendBuffer *buffer, bool superseding = false)
+    {
+        bool replaced = false;
+        if (superseding && superseded_ >= 0)
+        {
+            SendBuffer *old = buffers_[superseded_];
+            bytes_ -= old->size();
+            old->release();
+            buffers_.erase(buffers_.begin() + superseded_);
+            quic_.erase(quic_.begin() + superseded_);
+            replaced = true;
+        }
+        if (superseding)
+            superseded_ = static_cast<int32_t>(buffers_.size());
+
+        buffer->addRef();
+        buffers_.push_back(buffer);
+        quic_.push_back(*buffer->quicBuffer());
+        bytes_ += buffer->size();
+        return replaced;
+    }
+
+    // Trả mọi buffer và huỷ lô (gửi xong hoặc không gửi được)
+    void release()
+    {
+        for (SendBuffer *buffer : buffers_)
+            buffer->release();
+        delete this;
+    }
+
+    const QUIC_BUFFER *quicBuffers() const { return quic_.data(); }
+    uint32_t count() const { return static_cast<uint32_t>(quic_.size()); }
+    uint64_t bytes() const { return bytes_; }
+
+private:
+    SendBatch() = default;
+    ~SendBatch() = default;
+
+    std::vector<SendBuffer *> buffers_;
+    std::vector<QUIC_BUFFER> quic_;
+    uint64_t bytes_ = 0;
+    int32_t superseded_ = -1; // vị trí tin superseding hiện có, -1 nếu không có
+};
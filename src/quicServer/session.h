@@ -0,0 +1,171 @@
+#pragma once
+#include <msquic.h>
+#include <boost/asio/io_context.hpp>
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <vector>
+#include "sendBuffer.h"
+#include "tokenBucket.h"
+#include "../message/frameReader.h"
+#include "../transport/transport.h"
+
+class quicServer;
+
+// Ngưỡng ban đầu trước khi msquic báo IDEAL_SEND_BUFFER_SIZE (giá trị mặc định của msquic)
+constexpr uint64_t kDefaultSendWindow = 128 * 1024;
+
+// Số stream tối đa một client được mở: mỗi lớp lưu lượng một stream
+constexpr size_t kMaxStreamsPerSession = kTrafficClassCount;
+
+struct Session;
+
+// Một stream client mở trên kết nối. Con trỏ tới SessionStream là context của stream đó.
+// Lớp lưu lượng biết được từ byte mở đầu ở lần nhận đầu tiên (xem frame.h).
+struct SessionStream
+{
+    Session *Owner = nullptr;
+    // Ô đang có stream (kể cả đang chờ đóng); chỉ io_context của kết nối trả ô về
+    std::atomic<bool> InUse{false};
+    TrafficClass Class = TrafficClass::Control;
+    bool Classified = false; // chỉ worker của kết nối chạm vào
+
+    // Chỉ io_context của kết nối chạm vào (tin nhận được xử lý tuần tự trên đó)
+    FrameReader Reader;
+
+    // Dưới SendMutex của Owner
+    HQUIC Handle = nullptr;
+    SendBatch *Outbound = nullptr; // tin chờ gửi tới lần flush kế tiếp
+    // Byte đã StreamSend mà chưa SEND_COMPLETE, và ngưỡng msquic báo qua
+    // IDEAL_SEND_BUFFER_SIZE: vượt ngưỡng thì giữ Outbound lại, không gửi thêm
+    uint64_t InFlight = 0;
+    uint64_t SendWindow = kDefaultSendWindow;
+
+    void reset()
+    {
+        Class = TrafficClass::Control;
+        Classified = false;
+        Reader.reset();
+        Handle = nullptr;
+        if (Outbound)
+            Outbound->release();
+        Outbound = nullptr;
+        InFlight = 0;
+        SendWindow = kDefaultSendWindow;
+    }
+};
+
+// Trạng thái của một kết nối QUIC. Con trỏ tới Session là context của connection (và của
+// các stream qua SessionStream::Owner), nên callback của msquic lấy thẳng trạng thái mà
+// không tra map hay khoá chung; chỉ Transport API (tra theo ConnectionId từ luồng gameplay)
+// mới đi qua bảng sessions_ của quicServer.
+struct Session
+{
+    quicServer *Server = nullptr;
+    HQUIC Connection = nullptr;
+    ConnectionId Id = kInvalidConnection;
+    // io_context của kết nối trong pool: mọi việc của kết nối (và các stream) post vào đây
+    boost::asio::io_context *Io = nullptr;
+    std::atomic<uint32_t> RttMicros{0}; // RTT ước lượng gần nhất của msquic
+
+    std::array<SessionStream, kMaxStreamsPerSession> Streams;
+
+    // Trạng thái gửi: luồng gameplay và luồng worker của msquic cùng chạm vào nên có khoá
+    // riêng từng phiên
+    std::mutex SendMutex;
+    SessionStream *Primary = nullptr;               // stream đầu tiên client mở
+    SessionStream *Route[kTrafficClassCount] = {};  // stream đã khai báo cho từng lớp
+    uint16_t DatagramMax = 0;                       // 0 = client chưa bật nhận datagram
+    uint64_t DroppedSnapshots = 0;
+
+    // Kiểm soát đầu vào: chỉ io của kết nối chạm vào (tin nhận được xử lý tuần tự trên đó)
+    TokenBucket MessageBudget;
+    TokenBucket ByteBudget;
+    uint64_t IngressViolations = 0;
+
+    // stop() đã đóng handle của kết nối: việc nhận post sau đó trên io bị bỏ qua
+    bool Closed = false; // chỉ io của kết nối chạm vào
+
+    Session()
+    {
+        for (SessionStream &stream : Streams)
+            stream.Owner = this;
+    }
+
+    // Stream gửi cho một lớp: stream của lớp đó, không có thì stream Control, cuối cùng là
+    // stream đầu tiên (client cũ chỉ mở một stream). Gọi dưới SendMutex.
+    SessionStream *route(TrafficClass cls) const
+    {
+        if (SessionStream *stream = Route[static_cast<size_t>(cls)])
+            return stream;
+        if (SessionStream *stream = Route[static_cast<size_t>(TrafficClass::Control)])
+            return stream;
+        return Primary;
+    }
+
+    // Còn tin chờ flush trên stream nào không. Gọi dưới SendMutex.
+    bool hasOutbound() const
+    {
+        for (const SessionStream &stream : Streams)
+        {
+            if (stream.Outbound)
+                return true;
+        }
+        return false;
+    }
+
+    // Đưa về trạng thái vừa tạo trước khi tái sử dụng
+    void reset()
+    {
+        Server = nullptr;
+        Connection = nullptr;
+        Id = kInvalidConnection;
+        Io = nullptr;
+        RttMicros.store(0, std::memory_order_relaxed);
+        for (SessionStream &stream : Streams)
+        {
+            stream.reset();
+            stream.InUse.store(false, std::memory_order_relaxed);
+        }
+        Primary = nullptr;
+        for (SessionStream *&route : Route)
+            route = nullptr;
+        DatagramMax = 0;
+        DroppedSnapshots = 0;
+        IngressViolations = 0;
+        Closed = false;
+    }
+};
+
+// Cấp Session cho kết nối mới và nhận lại khi kết nối đóng hẳn. Session trả về được giữ
+// để tái sử dụng (kể cả capacity của bộ tách tin và lô gửi), không cấp phát lại mỗi kết nối.
+class SessionPool
+{
+public:
+    Session *acquire()
+    {
+        std::lock_guard<std::mutex> lk(mutex_);
+        if (free_.empty())
+        {
+            all_.push_back(std::make_unique<Session>());
+            return all_.back().get();
+        }
+        Session *session = free_.back();
+        free_.pop_back();
+        return session;
+    }
+
+    void release(Session *session)
+    {
+        session->reset();
+        std::lock_guard<std::mutex> lk(mutex_);
+        free_.push_back(session);
+    }
+
+private:
+    std::mutex mutex_;
+    std::vector<std::unique_ptr<Session>> all_;
+    std::vector<Session *> free_;
+};
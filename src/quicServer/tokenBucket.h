@@ -0,0 +1,48 @@
+#pragma once
+#include <algorithm>
+#include <cstdint>
+
+// Token bucket cho kiểm soát đầu vào: nạp `rate` token mỗi giây, tích tối đa `burst`.
+// Không khoá: mỗi bucket chỉ được một luồng dùng (bucket của kết nối chạy trên io của nó).
+class TokenBucket
+{
+public:
+    // rate <= 0 nghĩa là không giới hạn
+    void configure(double rate, double burst)
+    {
+        rate_ = rate;
+        burst_ = std::max(burst, 1.0);
+        tokens_ = burst_;
+        lastNs_ = 0;
+    }
+
+    bool unlimited() const { return rate_ <= 0; }
+
+    // Có đủ n token ở thời điểm nowNs (steady_clock) không; chưa trừ
+    bool available(double n, uint64_t nowNs)
+    {
+        if (unlimited())
+            return true;
+        refill(nowNs);
+        return tokens_ >= n;
+    }
+
+    void consume(double n)
+    {
+        if (!unlimited())
+            tokens_ -= n;
+    }
+
+private:
+    void refill(uint64_t nowNs)
+    {
+        if (lastNs_ != 0 && nowNs > lastNs_)
+            tokens_ = std::min(burst_, tokens_ + rate_ * static_cast<double>(nowNs - lastNs_) * 1e-9);
+        lastNs_ = nowNs;
+    }
+
+    double rate_ = 0;
+    double burst_ = 1;
+    double tokens_ = 1;
+    uint64_t lastNs_ = 0;
+};
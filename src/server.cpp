@@ -1,5 +1,5 @@
 #include "quicServer/quicServer.h"
-#include "core/gameplay.h"
+#include "core/roomManager.h"
 #include "init/init.h"
 #include "boost/asio.hpp"
 #include <curl/curl.h>
@@ -26,35 +26,39 @@ boost::asio::awaitable<void> runGameServer(io_context &io)
         co_return;
     }
 
-    // 3️⃣ Tạo server và gameplay
-    auto server = std::make_unique<quicServer>("../certs/server.crt", "../certs/server.key", io);
-    auto gameLogic = std::make_unique<Gameplay>(*server, io);
-
-    // 4️⃣ Gắn callbacks, post vào io_context để thread-safe
-    server->onMessageReceived = [gameLogic_ptr = gameLogic.get(), &io](HQUIC stream, const std::string &msg)
+    // 3️⃣ Tạo server và quản lý phòng (mỗi phòng một Gameplay, chia đều trên các core).
+    // Sự kiện mạng chạy trên pool io thread, mỗi kết nối cố định một thread.
+    GameplayConfig gameConfig;
+    if (!gameConfig.LoadConfig("core/config.json"))
+        std::cerr << "Failed to load Gameplay config, using defaults!" << std::endl;
+    auto ioPool = std::make_unique<IoContextPool>(gameConfig.ioThreads);
+    auto server = std::make_unique<quicServer>("../certs/server.crt", "../certs/server.key", *ioPool);
+    quicServer::IngressLimits ingress;
+    ingress.messagesPerSec = gameConfig.ingressMessagesPerSec;
+    ingress.messageBurst = gameConfig.ingressMessageBurst;
+    ingress.bytesPerSec = gameConfig.ingressBytesPerSec;
+    ingress.byteBurst = gameConfig.ingressByteBurst;
+    ingress.maxFrameBytes = static_cast<size_t>(gameConfig.maxFrameBytes);
+    server->setIngressLimits(ingress);
+    auto rooms = std::make_unique<RoomManager>(*server, gameConfig);
+
+    // 4️⃣ Gắn callbacks; RoomManager xếp lệnh vào hàng đợi của từng phòng
+    server->onMessage = [rooms_ptr = rooms.get(), log = gameConfig.logEvents](ConnectionId conn, std::string_view msg)
     {
         // log message raw nhận được
-        std::cout << "[Server] Received raw msg: " << msg << std::endl;
-
-        // đẩy sang io_context để xử lý
-        boost::asio::post(io, [gameLogic_ptr, stream, msg]()
-                          {
-        if (gameLogic_ptr) 
-            gameLogic_ptr->handleMessage(stream, msg); });
+        if (log)
+            std::cout << "[Server] Received raw msg: " << msg << std::endl;
+        rooms_ptr->handleMessage(conn, msg);
     };
 
-    server->onStreamStarted = [gameLogic_ptr = gameLogic.get(), &io](HQUIC conn, HQUIC stream)
+    server->onConnected = [rooms_ptr = rooms.get()](ConnectionId conn)
     {
-        boost::asio::post(io, [gameLogic_ptr, conn, stream]()
-                          {
-            if (gameLogic_ptr) gameLogic_ptr->handlePlayerConnected(conn, stream); });
+        rooms_ptr->handlePlayerConnected(conn);
     };
 
-    server->onClientDisconnected = [gameLogic_ptr = gameLogic.get(), &io](HQUIC stream)
+    server->onDisconnected = [rooms_ptr = rooms.get()](ConnectionId conn)
     {
-        boost::asio::post(io, [gameLogic_ptr, stream]()
-                          {
-            if (gameLogic_ptr) gameLogic_ptr->handlePlayerDisconnected(stream); });
+        rooms_ptr->handlePlayerDisconnected(conn);
     };
 
     // 5️⃣ Bắt đầu server
@@ -65,7 +69,8 @@ boost::asio::awaitable<void> runGameServer(io_context &io)
         co_return;
     }
 
-    gameLogic->startGameLoop();
+    ioPool->start();
+    rooms->start();
     std::cout << "Server is running. Press Enter to stop..." << std::endl;
 
     // 6️⃣ Signal handler Ctrl+C
@@ -73,8 +78,9 @@ boost::asio::awaitable<void> runGameServer(io_context &io)
     signals.async_wait([&](auto, auto)
                        {
         std::cout << "Signal received. Stopping server..." << std::endl;
-        gameLogic->stopGameLoop();
-        server->stop();
+        rooms->stop();
+        server->stop(); // đóng kết nối trên pool io nên phải trước ioPool->stop()
+        ioPool->stop();
         curl_global_cleanup();
         io.stop(); });
 
@@ -85,8 +91,9 @@ boost::asio::awaitable<void> runGameServer(io_context &io)
 
     // 8️⃣ Dừng server khi nhấn Enter
     std::cout << "Stopping server..." << std::endl;
-    gameLogic->stopGameLoop();
-    server->stop();
+    rooms->stop();
+    server->stop(); // đóng kết nối trên pool io nên phải trước ioPool->stop()
+    ioPool->stop();
     curl_global_cleanup();
 
     std::cout << "Server stopped. All resources cleaned up. :)" << std::endl;
@@ -0,0 +1,210 @@
+#include "loopbackTransport.h"
+#include <algorithm>
+
+LoopbackTransport::LoopbackTransport(size_t inboxLimit)
+    : inboxLimit_(inboxLimit)
+{
+}
+
+void LoopbackTransport::setDatagramSize(size_t bytes)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    datagramSize_ = bytes;
+}
+
+ConnectionId LoopbackTransport::connect()
+{
+    ConnectionId id;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        id = nextId_++;
+        inboxes_.emplace(id, Inbox{});
+        stats_.connections++;
+    }
+    if (onConnected)
+        onConnected(id);
+    return id;
+}
+
+void LoopbackTransport::clientSend(ConnectionId conn, const std::string &msg)
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (inboxes_.find(conn) == inboxes_.end())
+            return;
+        stats_.messagesReceived++;
+        stats_.bytesReceived += msg.size();
+    }
+    if (onMessage)
+        onMessage(conn, msg);
+}
+
+void LoopbackTransport::clientDisconnect(ConnectionId conn)
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (inboxes_.erase(conn) == 0)
+            return;
+    }
+    if (onDisconnected)
+        onDisconnected(conn);
+}
+
+size_t LoopbackTransport::receive(ConnectionId conn, std::deque<Payload> &out)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = inboxes_.find(conn);
+    if (it == inboxes_.end())
+        return 0;
+
+    std::deque<Payload> &messages = it->second.messages;
+    const size_t n = messages.size();
+    for (auto &m : messages)
+        out.push_back(std::move(m));
+    messages.clear();
+    it->second.superseding.clear();
+    it->second.bytes = 0;
+    return n;
+}
+
+bool LoopbackTransport::sendMessage(ConnectionId conn, std::string &&msg, TrafficClass)
+{
+    Payload payload = std::make_shared<const std::string>(std::move(msg));
+    std::lock_guard<std::mutex> lock(mutex_);
+    return deliver(conn, payload);
+}
+
+size_t LoopbackTransport::broadcast(const std::vector<ConnectionId> &conns, std::string msg, TrafficClass)
+{
+    Payload payload = std::make_shared<const std::string>(std::move(msg));
+    size_t sent = 0;
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (ConnectionId conn : conns)
+    {
+        if (deliver(conn, payload))
+            ++sent;
+    }
+    return sent;
+}
+
+bool LoopbackTransport::sendUnreliable(ConnectionId conn, std::string &&msg)
+{
+    Payload payload = std::make_shared<const std::string>(std::move(msg));
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!deliver(conn, payload, true))
+        return false;
+    if (payload->size() <= datagramSize_)
+        stats_.datagrams++;
+    else if (datagramSize_ > 0)
+        stats_.datagramFallbacks++;
+    return true;
+}
+
+size_t LoopbackTransport::broadcastUnreliable(const std::vector<ConnectionId> &conns, std::string msg)
+{
+    Payload payload = std::make_shared<const std::string>(std::move(msg));
+    size_t sent = 0;
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (ConnectionId conn : conns)
+    {
+        if (deliver(conn, payload, true))
+            ++sent;
+    }
+    return sent;
+}
+
+Transport::SendQueueStats LoopbackTransport::sendQueue(ConnectionId conn)
+{
+    SendQueueStats stats;
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = inboxes_.find(conn);
+    if (it == inboxes_.end())
+        return stats;
+    stats.queuedMessages = it->second.messages.size();
+    stats.queuedBytes = it->second.bytes;
+    stats.droppedSnapshots = it->second.droppedSnapshots;
+    return stats;
+}
+
+size_t LoopbackTransport::maxDatagramSize(ConnectionId)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    return datagramSize_;
+}
+
+void LoopbackTransport::flush(const std::vector<ConnectionId> &conns)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (ConnectionId conn : conns)
+    {
+        auto it = inboxes_.find(conn);
+        if (it == inboxes_.end() || it->second.unflushed == 0)
+            continue;
+        Inbox &inbox = it->second;
+        stats_.sends++;
+        if (inbox.unflushed > 1)
+        {
+            stats_.coalescedMessages += inbox.unflushed - 1;
+            stats_.coalescedBytes += inbox.unflushedBytes;
+        }
+        inbox.unflushed = 0;
+        inbox.unflushedBytes = 0;
+    }
+}
+
+void LoopbackTransport::disconnect(ConnectionId conn)
+{
+    // Server đóng kết nối: xử lý như client rời đi
+    clientDisconnect(conn);
+}
+
+LoopbackTransport::Stats LoopbackTransport::stats()
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    return stats_;
+}
+
+bool LoopbackTransport::deliver(ConnectionId conn, const Payload &payload, bool superseding)
+{
+    auto it = inboxes_.find(conn);
+    if (it == inboxes_.end())
+        return false;
+
+    Inbox &inbox = it->second;
+    std::deque<Payload> &messages = inbox.messages;
+    if (inboxLimit_ && messages.size() >= inboxLimit_)
+    {
+        // Hộp thư đầy, cùng luật với SendBatch của quicServer: bỏ snapshot cũ nhất đang chờ
+        // dù tin mới là loại gì; không còn snapshot nào thì snapshot mới tự bị bỏ. Tin tin
+        // cậy chỉ bị bỏ khi hộp thư toàn tin tin cậy và tin mới cũng là tin tin cậy.
+        auto s = std::find(inbox.superseding.begin(), inbox.superseding.end(), 1);
+        if (s == inbox.superseding.end() && superseding)
+        {
+            inbox.droppedSnapshots++;
+            stats_.droppedSnapshots++;
+            return true;
+        }
+        size_t victim = 0;
+        if (s != inbox.superseding.end())
+        {
+            victim = static_cast<size_t>(s - inbox.superseding.begin());
+            inbox.droppedSnapshots++;
+            stats_.droppedSnapshots++;
+        }
+        else
+        {
+            stats_.dropped++;
+        }
+        inbox.bytes -= messages[victim]->size();
+        messages.erase(messages.begin() + victim);
+        inbox.superseding.erase(inbox.superseding.begin() + victim);
+    }
+    messages.push_back(payload);
+    inbox.superseding.push_back(superseding ? 1 : 0);
+    inbox.bytes += payload->size();
+    it->second.unflushed++;
+    it->second.unflushedBytes += payload->size();
+    stats_.messagesSent++;
+    stats_.bytesSent += payload->size();
+    return true;
+}
@@ -0,0 +1,88 @@
+#ifndef LOOPBACK_TRANSPORT_H
+#define LOOPBACK_TRANSPORT_H
+
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include "transport.h"
+
+// Transport hoàn toàn trong tiến trình: không socket, không msquic, không chứng chỉ.
+// Phía "client" (benchmark, kiểm thử tải, fuzz) gọi connect/clientSend/clientDisconnect;
+// các sự kiện onConnected/onMessage/onDisconnected được gọi đồng bộ ngay trong luồng
+// gọi nên thứ tự hoàn toàn tất định. Tin server gửi nằm trong hộp thư của từng kết
+// nối cho tới khi client lấy ra; broadcast dùng chung một bản dữ liệu.
+class LoopbackTransport : public Transport
+{
+public:
+    using Payload = std::shared_ptr<const std::string>;
+
+    // Giới hạn số tin chờ mỗi hộp thư (0 = không giới hạn). Khi đầy, snapshot
+    // (sendUnreliable) mới thay snapshot cũ nhất còn chờ, nếu không có thì tin cũ nhất bị
+    // bỏ, để hàng nghìn client không đọc không làm phình bộ nhớ.
+    explicit LoopbackTransport(size_t inboxLimit = 0);
+
+    // Giả lập kênh datagram với kích thước tối đa cho mọi kết nối (0 = tắt). Datagram
+    // không bao giờ mất, chỉ dùng để kiểm tra kích thước và đường đi của snapshot.
+    void setDatagramSize(size_t bytes);
+
+    // --- phía client ---
+    ConnectionId connect();
+    void clientSend(ConnectionId conn, const std::string &msg);
+    void clientDisconnect(ConnectionId conn);
+
+    // Chuyển mọi tin đang chờ của kết nối sang out (nối thêm); trả về số tin
+    size_t receive(ConnectionId conn, std::deque<Payload> &out);
+
+    // --- Transport (phía server) ---
+    bool sendMessage(ConnectionId conn, std::string &&msg, TrafficClass cls = TrafficClass::Control) override;
+    size_t broadcast(const std::vector<ConnectionId> &conns, std::string msg,
+                     TrafficClass cls = TrafficClass::Control) override;
+    void disconnect(ConnectionId conn) override;
+    bool sendUnreliable(ConnectionId conn, std::string &&msg) override;
+    size_t broadcastUnreliable(const std::vector<ConnectionId> &conns, std::string msg) override;
+    SendQueueStats sendQueue(ConnectionId conn) override;
+    size_t maxDatagramSize(ConnectionId conn) override;
+    void flush(const std::vector<ConnectionId> &conns) override;
+
+    // Thống kê tổng (an toàn khi gọi từ luồng khác)
+    struct Stats
+    {
+        uint64_t connections = 0;
+        uint64_t messagesSent = 0; // tin server gửi, mỗi người nhận tính một
+        uint64_t bytesSent = 0;
+        uint64_t messagesReceived = 0; // tin client gửi lên
+        uint64_t bytesReceived = 0;
+        uint64_t dropped = 0; // tin tin cậy bị bỏ vì hộp thư đầy toàn tin tin cậy
+        uint64_t droppedSnapshots = 0; // snapshot bị bỏ khi hộp thư đầy (bị thay hoặc tự bị bỏ)
+        uint64_t datagrams = 0;         // tin gửi qua kênh datagram
+        uint64_t datagramFallbacks = 0; // tin không vừa datagram, gửi như tin tin cậy
+        uint64_t sends = 0;             // số lần gửi nếu mỗi kết nối gửi một lần mỗi flush
+        uint64_t coalescedMessages = 0; // tin đi chung lần gửi với tin khác
+        uint64_t coalescedBytes = 0;
+    };
+    Stats stats();
+
+private:
+    struct Inbox
+    {
+        std::deque<Payload> messages;
+        std::deque<uint8_t> superseding; // song song với messages
+        uint64_t bytes = 0;
+        uint64_t droppedSnapshots = 0;
+        // Tin từ lần flush trước, chỉ để đếm: loopback vẫn giao tin ngay
+        uint32_t unflushed = 0;
+        uint64_t unflushedBytes = 0;
+    };
+
+    bool deliver(ConnectionId conn, const Payload &payload, bool superseding = false);
+
+    const size_t inboxLimit_;
+    size_t datagramSize_ = 0;
+    std::mutex mutex_;
+    std::unordered_map<ConnectionId, Inbox> inboxes_;
+    ConnectionId nextId_ = 1;
+    Stats stats_;
+};
+
+#endif // LOOPBACK_TRANSPORT_H
@@ -0,0 +1,92 @@
+#ifndef TRANSPORT_H
+#define TRANSPORT_H
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// Định danh kết nối do transport cấp, không bao giờ tái sử dụng trong một lần chạy.
+// Gameplay dùng luôn giá trị này làm ClientId của người chơi.
+using ConnectionId = uint64_t;
+constexpr ConnectionId kInvalidConnection = 0;
+
+// Lớp lưu lượng của tin server gửi. Transport nhiều stream gửi mỗi lớp trên stream riêng
+// với độ ưu tiên riêng, để một tin lớn của lớp thấp (guild, inventory) không chặn đầu
+// dòng snapshot hay tin điều khiển phía sau nó.
+enum class TrafficClass : uint8_t
+{
+    Control,  // join/welcome, xác thực, lỗi
+    Gameplay, // snapshot, trạng thái thế giới
+    Social,   // chat, thông báo
+    Bulk,     // guild, inventory và các phản hồi lớn khác
+};
+constexpr size_t kTrafficClassCount = 4;
+
+// Tầng vận chuyển giữa server game và client. Tầng trên (RoomManager, Gameplay) chỉ
+// biết ConnectionId nên chạy được trên QUIC thật (quicServer) hoặc hoàn toàn trong
+// tiến trình (LoopbackTransport) cho benchmark, kiểm thử tải và fuzz.
+class Transport
+{
+public:
+    virtual ~Transport() = default;
+
+    // Gửi một tin tới một kết nối; false nếu kết nối không còn
+    virtual bool sendMessage(ConnectionId conn, std::string &&msg, TrafficClass cls = TrafficClass::Control) = 0;
+
+    // Gửi cùng một tin đến nhiều kết nối (dữ liệu dùng chung); trả về số kết nối gửi thành công
+    virtual size_t broadcast(const std::vector<ConnectionId> &conns, std::string msg,
+                             TrafficClass cls = TrafficClass::Control) = 0;
+
+    // Gửi tin mà tin mới hơn làm tin cũ vô nghĩa (snapshot): đi qua kênh không tin cậy
+    // (QUIC DATAGRAM) nếu client hỗ trợ và tin vừa một datagram, để một gói mất không chặn
+    // các tin sau. Ngược lại gửi như sendMessage. Mỗi datagram chứa đúng một tin, cùng
+    // định dạng như trên stream. Khi kết nối đang nghẽn, tin chưa gửi kiểu này có thể bị
+    // thay bởi tin mới hơn cùng kiểu; tin của sendMessage/broadcast thì luôn được giữ.
+    // Luôn thuộc lớp Gameplay.
+    virtual bool sendUnreliable(ConnectionId conn, std::string &&msg)
+    {
+        return sendMessage(conn, std::move(msg), TrafficClass::Gameplay);
+    }
+
+    // Như sendUnreliable nhưng cho nhiều kết nối với một buffer chung
+    virtual size_t broadcastUnreliable(const std::vector<ConnectionId> &conns, std::string msg)
+    {
+        return broadcast(conns, std::move(msg), TrafficClass::Gameplay);
+    }
+
+    // Gửi đi các tin đang chờ của những kết nối này; gọi một lần cuối mỗi tick. Transport
+    // có thể giữ tin của sendMessage/broadcast/sendUnreliable tới lúc flush để mọi tin của
+    // một tick tới cùng kết nối đi chung một lần gửi. Mặc định gửi ngay nên không cần làm gì.
+    virtual void flush(const std::vector<ConnectionId> &) {}
+
+    // Kích thước tối đa một datagram tới kết nối, 0 nếu kênh datagram không dùng được
+    virtual size_t maxDatagramSize(ConnectionId) { return 0; }
+
+    // Server chủ động đóng một kết nối; onDisconnected vẫn được gọi như bình thường
+    virtual void disconnect(ConnectionId conn) = 0;
+
+    // Trạng thái hàng đợi gửi của một kết nối
+    struct SendQueueStats
+    {
+        size_t queuedMessages = 0;     // tin chờ gửi trong transport
+        size_t queuedBytes = 0;
+        size_t inFlightBytes = 0;      // đã giao cho tầng dưới, chưa gửi xong
+        uint64_t droppedSnapshots = 0; // tin sendUnreliable bị thay bởi tin mới hơn
+    };
+    virtual SendQueueStats sendQueue(ConnectionId) { return {}; }
+
+    // RTT ước lượng của kết nối (micro giây), 0 nếu transport không đo được
+    virtual uint32_t roundTripMicros(ConnectionId) { return 0; }
+
+    // Sự kiện phía server, gán trước khi transport bắt đầu nhận kết nối.
+    // Có thể được gọi từ luồng bất kỳ của transport. View của onMessage có thể trỏ thẳng
+    // vào buffer nhận của transport nên chỉ hợp lệ trong lúc gọi.
+    std::function<void(ConnectionId)> onConnected;
+    std::function<void(ConnectionId, std::string_view)> onMessage;
+    std::function<void(ConnectionId)> onDisconnected;
+};
+
+#endif // TRANSPORT_H
@@ -0,0 +1,686 @@
+// Bầy bot QUIC không giao diện để đo sức chứa thật của server: mở N kết nối (ALPN "game"),
+// join rồi gửi move/shoot/ack theo nhịp cấu hình, giống client thật. Cuối lần chạy in báo
+// cáo dạng key=value (và tuỳ chọn một file JSON) để so sánh giữa các build:
+//   - độ giãn (jitter) khoảng cách giữa hai snapshot so với chu kỳ tick,
+//   - độ trễ từ lúc gửi move tới khi snapshot cho thấy người chơi của bot ở đúng vị trí đó,
+//   - số byte server gửi xuống (tầng ứng dụng và tổng byte QUIC trên dây).
+//
+//   loadgen [bots=100] [seconds=30] [--host H] [--port P] [--move-hz N] [--shoot-hz N]
+//           [--pattern random|circle] [--script FILE] [--json] [--datagram]
+//           [--connect-rate N] [--tick-rate N] [--report FILE]
+//
+// --pattern circle: mỗi bot đi vòng tròn quanh điểm xuất phát (kịch bản cố định, lặp lại
+// được); random: bước ngẫu nhiên theo seed của bot. --script FILE: mỗi dòng là một tin JSON,
+// mỗi bot gửi lần lượt theo nhịp move và quay vòng (không đo độ trễ cho các tin này).
+// --datagram bật nhận datagram để server gửi snapshot qua QUIC DATAGRAM.
+#include <msquic.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <numbers>
+#include <random>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+#include <nlohmann/json.hpp>
+#include "src/message/frame.h"
+#include "src/message/frameReader.h"
+
+using json = nlohmann::json;
+using Clock = std::chrono::steady_clock;
+
+namespace
+{
+    constexpr uint8_t kSnapshotMessageType = 0x01; // khớp core/snapshotCodec.h
+    constexpr size_t kMaxPendingProbes = 64;
+    constexpr auto kProbeTimeout = std::chrono::seconds(5);
+    constexpr double kCircleRadius = 60.0;
+
+    const QUIC_API_TABLE *MsQuic = nullptr;
+
+    struct Options
+    {
+        int bots = 100;
+        int seconds = 30;
+        std::string host = "127.0.0.1";
+        uint16_t port = 4443;
+        double moveHz = 20.0;
+        double shootHz = 1.0;
+        bool circle = false;
+        std::vector<std::string> script;
+        bool json = false;
+        bool datagram = false;
+        int connectRate = 500;
+        int tickRate = 20;
+        std::string report;
+    };
+
+    // Một move đã gửi, chờ snapshot cho thấy người chơi ở đúng vị trí đó
+    struct Probe
+    {
+        Clock::time_point sent;
+        int x, y;
+    };
+
+    struct Bot
+    {
+        uint32_t index = 0;
+        std::string name;
+        HQUIC connection = nullptr;
+        HQUIC stream = nullptr;
+        std::atomic<bool> connected{false};
+        std::atomic<bool> failed{false};
+        std::atomic<bool> shutdownComplete{false};
+
+        // Luồng worker của msquic (nhận) và luồng chính (gửi) cùng chạm vào phần dưới
+        std::mutex mutex;
+        FrameReader reader{16 * 1024 * 1024};
+        bool welcomed = false;
+        int64_t ownId = -1;
+        int64_t lastTick = -1;
+        int64_t ackedTick = -1;
+        bool haveLastSnapshot = false;
+        Clock::time_point lastSnapshot;
+        std::deque<Probe> pending;
+        std::vector<double> interarrivalMs;
+        std::vector<double> latencyMs;
+        uint64_t snapshots = 0;
+        uint64_t bytesIn = 0;
+        uint64_t messagesIn = 0;
+        uint64_t datagramsIn = 0;
+
+        // Chỉ luồng chính
+        int x = 0, y = 0, originX = 0, originY = 0;
+        double angle = 0.0;
+        size_t scriptPos = 0;
+        Clock::time_point nextMove, nextShoot;
+        uint64_t messagesOut = 0;
+        uint64_t bytesOut = 0;
+        std::mt19937 rng;
+    };
+
+    // Buffer gửi sống tới SEND_COMPLETE
+    struct SendRequest
+    {
+        QUIC_BUFFER buffer;
+        std::string data;
+    };
+
+    bool sendText(Bot &bot, std::string msg)
+    {
+        if (!bot.stream)
+            return false;
+        msg.push_back('\n');
+        auto *req = new SendRequest{};
+        req->data = std::move(msg);
+        req->buffer.Buffer = reinterpret_cast<uint8_t *>(req->data.data());
+        req->buffer.Length = static_cast<uint32_t>(req->data.size());
+        if (QUIC_FAILED(MsQuic->StreamSend(bot.stream, &req->buffer, 1, QUIC_SEND_FLAG_NONE, req)))
+        {
+            delete req;
+            return false;
+        }
+        bot.messagesOut++;
+        bot.bytesOut += req->buffer.Length;
+        return true;
+    }
+
+    bool readVarint(const uint8_t *&p, const uint8_t *end, uint64_t &v)
+    {
+        v = 0;
+        for (int shift = 0; p < end && shift < 64; shift += 7)
+        {
+            const uint8_t b = *p++;
+            v |= static_cast<uint64_t>(b & 0x7F) << shift;
+            if (!(b & 0x80))
+                return true;
+        }
+        return false;
+    }
+
+    bool readSvarint(const uint8_t *&p, const uint8_t *end, int64_t &v)
+    {
+        uint64_t u;
+        if (!readVarint(p, end, u))
+            return false;
+        v = static_cast<int64_t>(u >> 1) ^ -static_cast<int64_t>(u & 1);
+        return true;
+    }
+
+    // Gọi dưới bot.mutex khi snapshot cho biết vị trí người chơi của bot
+    void observeOwnPosition(Bot &bot, int x, int y, Clock::time_point now)
+    {
+        // Khớp move cũ nhất tới đúng vị trí này; các move cũ hơn nó đã bị ghi đè
+        for (size_t k = 0; k < bot.pending.size(); ++k)
+        {
+            if (bot.pending[k].x == x && bot.pending[k].y == y)
+            {
+                bot.latencyMs.push_back(std::chrono::duration<double, std::milli>(now - bot.pending[k].sent).count());
+                bot.pending.erase(bot.pending.begin(), bot.pending.begin() + k + 1);
+                return;
+            }
+        }
+    }
+
+    // false nếu snapshot cũ hơn snapshot đã nhận (datagram đến trễ hoặc trùng)
+    bool onSnapshotTick(Bot &bot, int64_t tick, Clock::time_point now)
+    {
+        if (tick <= bot.lastTick)
+            return false;
+        if (bot.haveLastSnapshot)
+            bot.interarrivalMs.push_back(std::chrono::duration<double, std::milli>(now - bot.lastSnapshot).count());
+        bot.haveLastSnapshot = true;
+        bot.lastSnapshot = now;
+        bot.lastTick = tick;
+        bot.snapshots++;
+        return true;
+    }
+
+    // Chỉ đọc phần đầu và danh sách người chơi của bin1 (xem core/snapshotCodec.cpp)
+    void handleBinary(Bot &bot, const uint8_t *p, const uint8_t *end, Clock::time_point now)
+    {
+        if (end - p < 2 || p[0] != kSnapshotMessageType)
+            return;
+        p += 2;
+        uint64_t tick, baseline, playerCount, n;
+        if (!readVarint(p, end, tick) || !readVarint(p, end, baseline) || !readVarint(p, end, playerCount) ||
+            !readVarint(p, end, n))
+            return;
+        if (!onSnapshotTick(bot, static_cast<int64_t>(tick), now))
+            return;
+
+        for (uint64_t k = 0; k < n && p < end; ++k)
+        {
+            uint64_t id, len = 0;
+            int64_t x, y, score;
+            if (!readVarint(p, end, id) || p >= end)
+                return;
+            const uint8_t flags = *p++;
+            if (!readSvarint(p, end, x) || !readSvarint(p, end, y) || !readSvarint(p, end, score))
+                return;
+            if (flags & 1)
+            {
+                if (!readVarint(p, end, len) || static_cast<uint64_t>(end - p) < len)
+                    return;
+                if (bot.ownId < 0 && std::string_view(reinterpret_cast<const char *>(p), len) == bot.name)
+                    bot.ownId = static_cast<int64_t>(id);
+                p += len;
+            }
+            if (static_cast<int64_t>(id) == bot.ownId)
+                observeOwnPosition(bot, static_cast<int>(x), static_cast<int>(y), now);
+        }
+    }
+
+    void handleJson(Bot &bot, std::string_view text, Clock::time_point now)
+    {
+        auto j = json::parse(text, nullptr, false);
+        if (j.is_discarded() || !j.is_object())
+            return;
+        if (j.value("action", "") == "welcome")
+        {
+            bot.welcomed = true;
+            return;
+        }
+        const int64_t tick = j.value("tick", int64_t(-1));
+        if (tick < 0 || !onSnapshotTick(bot, tick, now))
+            return;
+
+        auto players = j.find("players");
+        if (players == j.end() || !players->is_array())
+            return;
+        for (const auto &pl : *players)
+        {
+            const int64_t id = pl.value("id", int64_t(-1));
+            if (bot.ownId < 0 && pl.value("name", "") == bot.name)
+                bot.ownId = id;
+            if (id >= 0 && id == bot.ownId)
+                observeOwnPosition(bot, pl.value("x", -1), pl.value("y", -1), now);
+        }
+    }
+
+    // Một tin trọn vẹn (đã bỏ header khung / '\n'), gọi dưới bot.mutex
+    void handleMessage(Bot &bot, std::string_view msg, bool binary, Clock::time_point now)
+    {
+        bot.messagesIn++;
+        if (binary)
+            handleBinary(bot, reinterpret_cast<const uint8_t *>(msg.data()),
+                         reinterpret_cast<const uint8_t *>(msg.data() + msg.size()), now);
+        else
+            handleJson(bot, msg, now);
+    }
+
+    // Handle stream và kết nối chỉ được đóng ở luồng chính lúc kết thúc (luồng chính vẫn
+    // gửi trên stream); stream bị đóng giữa chừng thì StreamSend chỉ trả lỗi
+    QUIC_STATUS QUIC_API streamCallback(HQUIC, void *ctx, QUIC_STREAM_EVENT *evt)
+    {
+        auto *bot = static_cast<Bot *>(ctx);
+        switch (evt->Type)
+        {
+        case QUIC_STREAM_EVENT_RECEIVE:
+        {
+            const auto now = Clock::now();
+            std::lock_guard<std::mutex> lk(bot->mutex);
+            for (uint32_t i = 0; i < evt->RECEIVE.BufferCount; ++i)
+            {
+                const QUIC_BUFFER &buf = evt->RECEIVE.Buffers[i];
+                bot->bytesIn += buf.Length;
+                // FrameReader không cho biết loại khung: payload bin1 bắt đầu bằng type 0x01,
+                // JSON bắt đầu bằng '{'
+                bot->reader.feed(buf.Buffer, buf.Length, [&](std::string_view msg)
+                                 { handleMessage(*bot, msg, static_cast<uint8_t>(msg[0]) == kSnapshotMessageType, now); });
+            }
+            break;
+        }
+        case QUIC_STREAM_EVENT_SEND_COMPLETE:
+            delete static_cast<SendRequest *>(evt->SEND_COMPLETE.ClientContext);
+            break;
+        default:
+            break;
+        }
+        return QUIC_STATUS_SUCCESS;
+    }
+
+    QUIC_STATUS QUIC_API connectionCallback(HQUIC, void *ctx, QUIC_CONNECTION_EVENT *evt)
+    {
+        auto *bot = static_cast<Bot *>(ctx);
+        switch (evt->Type)
+        {
+        case QUIC_CONNECTION_EVENT_CONNECTED:
+            bot->connected.store(true, std::memory_order_release);
+            break;
+        case QUIC_CONNECTION_EVENT_DATAGRAM_RECEIVED:
+        {
+            // Mỗi datagram là một tin nguyên vẹn, cùng định dạng như trên stream
+            const QUIC_BUFFER *buf = evt->DATAGRAM_RECEIVED.Buffer;
+            if (!buf || buf->Length == 0)
+                break;
+            const auto now = Clock::now();
+            std::string_view msg(reinterpret_cast<const char *>(buf->Buffer), buf->Length);
+            std::lock_guard<std::mutex> lk(bot->mutex);
+            bot->bytesIn += buf->Length;
+            bot->datagramsIn++;
+            if (static_cast<uint8_t>(msg[0]) == kBinaryFrameMarker && msg.size() > kBinaryFrameHeaderSize)
+                handleMessage(*bot, msg.substr(kBinaryFrameHeaderSize), true, now);
+            else
+                handleMessage(*bot, msg.back() == '\n' ? msg.substr(0, msg.size() - 1) : msg, false, now);
+            break;
+        }
+        case QUIC_CONNECTION_EVENT_SHUTDOWN_COMPLETE:
+            if (!bot->connected.load(std::memory_order_acquire))
+                bot->failed.store(true, std::memory_order_release);
+            bot->shutdownComplete.store(true, std::memory_order_release);
+            break;
+        default:
+            break;
+        }
+        return QUIC_STATUS_SUCCESS;
+    }
+
+    bool startBot(Bot &bot, HQUIC configuration, const Options &opt)
+    {
+        if (QUIC_FAILED(MsQuic->ConnectionOpen(nullptr, connectionCallback, &bot, &bot.connection)))
+            return false;
+        // Stream mở trước khi bắt tay xong: join đi ngay khi kết nối sẵn sàng
+        if (QUIC_FAILED(MsQuic->StreamOpen(bot.connection, QUIC_STREAM_OPEN_FLAG_NONE, streamCallback, &bot, &bot.stream)) ||
+            QUIC_FAILED(MsQuic->StreamStart(bot.stream, QUIC_STREAM_START_FLAG_IMMEDIATE)) ||
+            QUIC_FAILED(MsQuic->ConnectionStart(bot.connection, configuration, QUIC_ADDRESS_FAMILY_UNSPEC, opt.host.c_str(), opt.port)))
+        {
+            if (bot.stream)
+                MsQuic->StreamClose(bot.stream);
+            MsQuic->ConnectionClose(bot.connection);
+            bot.stream = nullptr;
+            bot.connection = nullptr;
+            return false;
+        }
+
+        json join = {{"action", "join"}, {"player", bot.name}};
+        if (!opt.json)
+            join["encodings"] = {"bin1"};
+        return sendText(bot, join.dump());
+    }
+
+    void nextPosition(Bot &bot, const Options &opt)
+    {
+        if (opt.circle)
+        {
+            bot.angle += 2.0 * std::numbers::pi / (opt.moveHz * 4.0); // một vòng mỗi 4 giây
+            bot.x = bot.originX + static_cast<int>(std::lround(kCircleRadius * std::cos(bot.angle)));
+            bot.y = bot.originY + static_cast<int>(std::lround(kCircleRadius * std::sin(bot.angle)));
+            return;
+        }
+        std::uniform_int_distribution<int> step(-10, 10);
+        bot.x = std::clamp(bot.x + step(bot.rng), 0, 1999);
+        bot.y = std::clamp(bot.y + step(bot.rng), 0, 1999);
+    }
+
+    // Gửi các tin tới hạn của một bot (luồng chính)
+    void drive(Bot &bot, const Options &opt, Clock::time_point now, Clock::duration movePeriod, Clock::duration shootPeriod)
+    {
+        if (!bot.connected.load(std::memory_order_acquire) || bot.failed.load(std::memory_order_acquire))
+            return;
+
+        if (now >= bot.nextMove)
+        {
+            bot.nextMove += movePeriod;
+            if (bot.nextMove < now)
+                bot.nextMove = now + movePeriod; // không gửi dồn sau khi bị chậm
+
+            int64_t ack = -1;
+            if (opt.script.empty())
+            {
+                nextPosition(bot, opt);
+                std::lock_guard<std::mutex> lk(bot.mutex);
+                if (bot.pending.size() >= kMaxPendingProbes || (!bot.pending.empty() && now - bot.pending.front().sent > kProbeTimeout))
+                    bot.pending.pop_front();
+                bot.pending.push_back({now, bot.x, bot.y});
+                if (bot.lastTick > bot.ackedTick)
+                    ack = bot.ackedTick = bot.lastTick;
+            }
+            if (opt.script.empty())
+                sendText(bot, "{\"action\":\"move\",\"x\":" + std::to_string(bot.x) + ",\"y\":" + std::to_string(bot.y) + "}");
+            else
+                sendText(bot, opt.script[bot.scriptPos++ % opt.script.size()]);
+            if (ack >= 0)
+                sendText(bot, "{\"action\":\"ack\",\"tick\":" + std::to_string(ack) + "}");
+        }
+
+        if (opt.shootHz > 0 && opt.script.empty() && now >= bot.nextShoot)
+        {
+            bot.nextShoot += shootPeriod;
+            if (bot.nextShoot < now)
+                bot.nextShoot = now + shootPeriod;
+            std::uniform_real_distribution<double> dir(-1.0, 1.0);
+            double dx = dir(bot.rng), dy = dir(bot.rng);
+            if (dx == 0.0 && dy == 0.0)
+                dx = 1.0;
+            int64_t tick;
+            {
+                std::lock_guard<std::mutex> lk(bot.mutex);
+                tick = bot.lastTick;
+            }
+            json shoot = {{"action", "shoot"}, {"x", bot.x}, {"y", bot.y}, {"dx", dx}, {"dy", dy}};
+            if (tick > 0)
+                shoot["tick"] = tick;
+            sendText(bot, shoot.dump());
+        }
+    }
+
+    struct Percentiles
+    {
+        size_t count = 0;
+        double p50 = 0, p99 = 0, max = 0;
+    };
+
+    Percentiles percentiles(std::vector<double> &v)
+    {
+        Percentiles p;
+        p.count = v.size();
+        if (v.empty())
+            return p;
+        std::sort(v.begin(), v.end());
+        p.p50 = v[v.size() / 2];
+        p.p99 = v[std::min(v.size() - 1, v.size() * 99 / 100)];
+        p.max = v.back();
+        return p;
+    }
+
+    bool parseArgs(int argc, char **argv, Options &opt)
+    {
+        int positional = 0;
+        for (int i = 1; i < argc; ++i)
+        {
+            const bool hasValue = i + 1 < argc;
+            if (std::strcmp(argv[i], "--host") == 0 && hasValue)
+                opt.host = argv[++i];
+            else if (std::strcmp(argv[i], "--port") == 0 && hasValue)
+                opt.port = static_cast<uint16_t>(std::atoi(argv[++i]));
+            else if (std::strcmp(argv[i], "--move-hz") == 0 && hasValue)
+                opt.moveHz = std::max(0.1, std::atof(argv[++i]));
+            else if (std::strcmp(argv[i], "--shoot-hz") == 0 && hasValue)
+                opt.shootHz = std::max(0.0, std::atof(argv[++i]));
+            else if (std::strcmp(argv[i], "--pattern") == 0 && hasValue)
+                opt.circle = std::strcmp(argv[++i], "circle") == 0;
+            else if (std::strcmp(argv[i], "--script") == 0 && hasValue)
+            {
+                std::ifstream file(argv[++i]);
+                if (!file)
+                {
+                    std::cerr << "Cannot open script " << argv[i] << "\n";
+                    return false;
+                }
+                for (std::string line; std::getline(file, line);)
+                {
+                    if (!line.empty() && line[0] != '#')
+                        opt.script.push_back(line);
+                }
+            }
+            else if (std::strcmp(argv[i], "--json") == 0)
+                opt.json = true;
+            else if (std::strcmp(argv[i], "--datagram") == 0)
+                opt.datagram = true;
+            else if (std::strcmp(argv[i], "--connect-rate") == 0 && hasValue)
+                opt.connectRate = std::max(1, std::atoi(argv[++i]));
+            else if (std::strcmp(argv[i], "--tick-rate") == 0 && hasValue)
+                opt.tickRate = std::max(1, std::atoi(argv[++i]));
+            else if (std::strcmp(argv[i], "--report") == 0 && hasValue)
+                opt.report = argv[++i];
+            else if (positional++ == 0)
+                opt.bots = std::max(1, std::atoi(argv[i]));
+            else
+                opt.seconds = std::max(1, std::atoi(argv[i]));
+        }
+        return true;
+    }
+}
+
+int main(int argc, char **argv)
+{
+    Options opt;
+    if (!parseArgs(argc, argv, opt))
+        return 1;
+
+    if (QUIC_FAILED(MsQuicOpen2(&MsQuic)))
+    {
+        std::cerr << "Failed to open MsQuic\n";
+        return 1;
+    }
+
+    HQUIC registration = nullptr;
+    HQUIC configuration = nullptr;
+    QUIC_REGISTRATION_CONFIG regConfig{"loadgen", QUIC_EXECUTION_PROFILE_TYPE_MAX_THROUGHPUT};
+    QUIC_BUFFER alpn{};
+    const char *alpnStr = "game";
+    alpn.Buffer = (uint8_t *)alpnStr;
+    alpn.Length = (uint32_t)strlen(alpnStr);
+
+    QUIC_SETTINGS settings{};
+    settings.IsSet.IdleTimeoutMs = TRUE;
+    settings.IdleTimeoutMs = 10000;
+    settings.IsSet.DatagramReceiveEnabled = TRUE;
+    settings.DatagramReceiveEnabled = opt.datagram ? TRUE : FALSE;
+
+    // Server dùng chứng chỉ tự ký trong certs/: bỏ kiểm tra chứng chỉ
+    QUIC_CREDENTIAL_CONFIG cred{};
+    cred.Type = QUIC_CREDENTIAL_TYPE_NONE;
+    cred.Flags = (QUIC_CREDENTIAL_FLAGS)(QUIC_CREDENTIAL_FLAG_CLIENT | QUIC_CREDENTIAL_FLAG_NO_CERTIFICATE_VALIDATION);
+
+    if (QUIC_FAILED(MsQuic->RegistrationOpen(&regConfig, &registration)) ||
+        QUIC_FAILED(MsQuic->ConfigurationOpen(registration, &alpn, 1, &settings, sizeof(settings), nullptr, &configuration)) ||
+        QUIC_FAILED(MsQuic->ConfigurationLoadCredential(configuration, &cred)))
+    {
+        std::cerr << "Failed to set up MsQuic client configuration\n";
+        if (configuration)
+            MsQuic->ConfigurationClose(configuration);
+        if (registration)
+            MsQuic->RegistrationClose(registration);
+        MsQuicClose(MsQuic);
+        return 1;
+    }
+
+    std::vector<std::unique_ptr<Bot>> bots;
+    bots.reserve(opt.bots);
+    std::mt19937 seeds(12345);
+    std::uniform_int_distribution<int> coord(100, 1899);
+    for (int i = 0; i < opt.bots; ++i)
+    {
+        auto bot = std::make_unique<Bot>();
+        bot->index = static_cast<uint32_t>(i);
+        bot->name = "lg" + std::to_string(i);
+        bot->rng.seed(seeds());
+        bot->x = bot->originX = coord(bot->rng);
+        bot->y = bot->originY = coord(bot->rng);
+        bots.push_back(std::move(bot));
+    }
+
+    const auto movePeriod = std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(1.0 / opt.moveHz));
+    const auto shootPeriod = opt.shootHz > 0
+                                 ? std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(1.0 / opt.shootHz))
+                                 : Clock::duration::max();
+    const auto connectPeriod = std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(1.0 / opt.connectRate));
+
+    std::cout << "loadgen: " << opt.bots << " bots -> " << opt.host << ":" << opt.port << " for " << opt.seconds
+              << "s, move " << opt.moveHz << "Hz shoot " << opt.shootHz << "Hz\n";
+
+    // Mở kết nối dần theo connect-rate (không dồn cả nghìn handshake một lúc), đồng thời
+    // lái các bot đã vào. Thời gian đo tính từ lúc bot cuối cùng được mở.
+    const auto start = Clock::now();
+    size_t started = 0;
+    auto nextConnect = start;
+    auto measureEnd = Clock::time_point::max();
+    uint64_t startFailures = 0;
+    while (Clock::now() < measureEnd)
+    {
+        const auto now = Clock::now();
+        while (started < bots.size() && now >= nextConnect)
+        {
+            Bot &bot = *bots[started++];
+            bot.nextMove = now + movePeriod;
+            bot.nextShoot = now + shootPeriod / 2;
+            if (!startBot(bot, configuration, opt))
+            {
+                bot.failed.store(true);
+                ++startFailures;
+            }
+            nextConnect += connectPeriod;
+            if (started == bots.size())
+                measureEnd = now + std::chrono::seconds(opt.seconds);
+        }
+        for (auto &bot : bots)
+            drive(*bot, opt, now, movePeriod, shootPeriod);
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    const double elapsed = std::chrono::duration<double>(Clock::now() - start).count();
+
+    // Gom số liệu trước khi đóng kết nối
+    std::vector<double> interarrival, jitter, latency;
+    uint64_t connected = 0, failed = 0, welcomed = 0, snapshots = 0, bytesIn = 0, messagesIn = 0, datagramsIn = 0;
+    uint64_t messagesOut = 0, bytesOut = 0, wireIn = 0, wireOut = 0;
+    const double periodMs = 1000.0 / opt.tickRate;
+    for (auto &bot : bots)
+    {
+        if (bot->connected.load())
+            ++connected;
+        if (bot->failed.load())
+            ++failed;
+        if (bot->connection && bot->connected.load() && !bot->shutdownComplete.load())
+        {
+            QUIC_STATISTICS_V2 stats{};
+            uint32_t size = sizeof(stats);
+            if (QUIC_SUCCEEDED(MsQuic->GetParam(bot->connection, QUIC_PARAM_CONN_STATISTICS_V2, &size, &stats)))
+            {
+                wireIn += stats.RecvTotalBytes;
+                wireOut += stats.SendTotalBytes;
+            }
+        }
+        std::lock_guard<std::mutex> lk(bot->mutex);
+        welcomed += bot->welcomed ? 1 : 0;
+        snapshots += bot->snapshots;
+        bytesIn += bot->bytesIn;
+        messagesIn += bot->messagesIn;
+        datagramsIn += bot->datagramsIn;
+        messagesOut += bot->messagesOut;
+        bytesOut += bot->bytesOut;
+        for (double ms : bot->interarrivalMs)
+        {
+            interarrival.push_back(ms);
+            jitter.push_back(std::abs(ms - periodMs));
+        }
+        latency.insert(latency.end(), bot->latencyMs.begin(), bot->latencyMs.end());
+    }
+
+    // Đóng êm rồi chờ SHUTDOWN_COMPLETE (tối đa vài giây); ConnectionClose với kết nối
+    // chưa đóng xong sẽ tự huỷ ngang
+    for (auto &bot : bots)
+    {
+        if (bot->connection && !bot->shutdownComplete.load(std::memory_order_acquire))
+            MsQuic->ConnectionShutdown(bot->connection, QUIC_CONNECTION_SHUTDOWN_FLAG_NONE, 0);
+    }
+    const auto closeDeadline = Clock::now() + std::chrono::seconds(5);
+    for (auto &bot : bots)
+    {
+        while (bot->connection && !bot->shutdownComplete.load(std::memory_order_acquire) && Clock::now() < closeDeadline)
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    for (auto &bot : bots)
+    {
+        if (bot->stream)
+            MsQuic->StreamClose(bot->stream);
+        if (bot->connection)
+            MsQuic->ConnectionClose(bot->connection);
+    }
+    MsQuic->ConfigurationClose(configuration);
+    MsQuic->RegistrationClose(registration);
+    MsQuicClose(MsQuic);
+
+    const Percentiles ia = percentiles(interarrival);
+    const Percentiles jt = percentiles(jitter);
+    const Percentiles lat = percentiles(latency);
+    const double measured = std::max(1e-9, elapsed);
+
+    std::cout << std::fixed << std::setprecision(2);
+    std::cout << "bots=" << opt.bots << " connected=" << connected << " failed=" << failed + startFailures
+              << " welcomed=" << welcomed << " wall=" << elapsed << "s encoding=" << (opt.json ? "json" : "bin1")
+              << " datagram=" << (opt.datagram ? 1 : 0) << "\n";
+    std::cout << "snapshots=" << snapshots << " per bot/s=" << snapshots / measured / std::max<uint64_t>(1, connected)
+              << " interarrival p50=" << ia.p50 << "ms p99=" << ia.p99 << "ms max=" << ia.max << "ms\n";
+    std::cout << "jitter (|interarrival - " << periodMs << "ms|) p50=" << jt.p50 << "ms p99=" << jt.p99 << "ms max=" << jt.max << "ms\n";
+    std::cout << "input->snapshot samples=" << lat.count << " p50=" << lat.p50 << "ms p99=" << lat.p99 << "ms max=" << lat.max << "ms\n";
+    std::cout << "server->client msgs=" << messagesIn << " datagrams=" << datagramsIn << " bytes=" << bytesIn
+              << " bytes/s=" << bytesIn / measured << " bytes/bot/s=" << bytesIn / measured / std::max<uint64_t>(1, connected)
+              << " wire bytes=" << wireIn << "\n";
+    std::cout << "client->server msgs=" << messagesOut << " bytes=" << bytesOut << " wire bytes=" << wireOut << "\n";
+
+    if (!opt.report.empty())
+    {
+        json report = {
+            {"bots", opt.bots},
+            {"connected", connected},
+            {"failed", failed + startFailures},
+            {"seconds", elapsed},
+            {"encoding", opt.json ? "json" : "bin1"},
+            {"datagram", opt.datagram},
+            {"moveHz", opt.moveHz},
+            {"shootHz", opt.shootHz},
+            {"snapshots", snapshots},
+            {"interarrivalMs", {{"p50", ia.p50}, {"p99", ia.p99}, {"max", ia.max}}},
+            {"jitterMs", {{"p50", jt.p50}, {"p99", jt.p99}, {"max", jt.max}}},
+            {"inputLatencyMs", {{"samples", lat.count}, {"p50", lat.p50}, {"p99", lat.p99}, {"max", lat.max}}},
+            {"serverBytes", {{"app", bytesIn}, {"wire", wireIn}, {"perSecond", bytesIn / measured}}},
+            {"clientBytes", {{"app", bytesOut}, {"wire", wireOut}}},
+        };
+        std::ofstream out(opt.report);
+        out << report.dump(2) << "\n";
+        std::cout << "Saved " << opt.report << "\n";
+    }
+    return connected > 0 ? 0 : 1;
+}
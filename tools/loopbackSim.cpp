@@ -0,0 +1,189 @@
+// Mô phỏng hàng nghìn client trong một tiến trình qua LoopbackTransport: mỗi tick các
+// client đọc snapshot, ack tick mới nhất và gửi lệnh di chuyển, sau đó server chạy
+// đúng một tick Gameplay. Mọi thứ chạy trên một luồng nên kết quả tất định (cùng
+// tham số cho cùng số byte), không phụ thuộc mạng.
+//
+//   loopback_sim [clients=2000] [ticks=200] [--json] [--datagram BYTES] [--slow N] [--no-ack]
+//
+// --datagram giả lập kênh datagram (ví dụ 1200): snapshot phải vừa kích thước đó.
+// --slow N: cứ N client có một client chỉ đọc hộp thư mỗi kSlowReadInterval tick, để
+// xem snapshot cũ bị thay thế thay vì dồn lại.
+// --no-ack: không client nào ack (như client JSON cũ). Mọi snapshot khi đó là snapshot
+// đầy đủ và phải gửi đủ dù vượt ngân sách byte; chương trình trả mã lỗi nếu có thay đổi
+// bị hoãn hoặc nếu snapshot không vượt ngân sách (kiểm tra không có ý nghĩa).
+#include "src/core/gameplay.h"
+#include "src/message/frame.h"
+#include "src/transport/loopbackTransport.h"
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <random>
+
+namespace
+{
+    constexpr int kSlowReadInterval = 100;
+
+    // Tick của snapshot trong một tin server gửi; -1 nếu không phải snapshot
+    int64_t snapshotTick(const std::string &msg)
+    {
+        if (msg.size() > kBinaryFrameHeaderSize + 2 && static_cast<uint8_t>(msg[0]) == kBinaryFrameMarker)
+        {
+            size_t pos = kBinaryFrameHeaderSize;
+            if (static_cast<uint8_t>(msg[pos]) != kSnapshotMessageType)
+                return -1;
+            pos += 2; // type + version
+            uint64_t tick = 0;
+            for (int shift = 0; pos < msg.size() && shift < 64; shift += 7)
+            {
+                uint8_t b = static_cast<uint8_t>(msg[pos++]);
+                tick |= static_cast<uint64_t>(b & 0x7F) << shift;
+                if (!(b & 0x80))
+                    return static_cast<int64_t>(tick);
+            }
+            return -1;
+        }
+
+        size_t pos = msg.find("\"tick\":");
+        return pos == std::string::npos ? -1 : std::atoll(msg.c_str() + pos + 7);
+    }
+}
+
+int main(int argc, char **argv)
+{
+    int clients = 2000;
+    int ticks = 200;
+    bool json = false;
+    size_t datagramSize = 0;
+    int slowEvery = 0;
+    bool noAck = false;
+    int positional = 0;
+    for (int i = 1; i < argc; ++i)
+    {
+        if (std::strcmp(argv[i], "--json") == 0)
+            json = true;
+        else if (std::strcmp(argv[i], "--datagram") == 0 && i + 1 < argc)
+            datagramSize = static_cast<size_t>(std::max(0, std::atoi(argv[++i])));
+        else if (std::strcmp(argv[i], "--slow") == 0 && i + 1 < argc)
+            slowEvery = std::max(0, std::atoi(argv[++i]));
+        else if (std::strcmp(argv[i], "--no-ack") == 0)
+            noAck = true;
+        else if (positional++ == 0)
+            clients = std::max(1, std::atoi(argv[i]));
+        else
+            ticks = std::max(1, std::atoi(argv[i]));
+    }
+
+    GameplayConfig config;
+    config.logEvents = false;
+    config.inputQueueCapacity = clients * 4 + 64;
+    config.worldSeed = 1;
+
+    boost::asio::io_context io;
+    LoopbackTransport transport(64);
+    transport.setDatagramSize(datagramSize);
+    Gameplay game(transport, io, config);
+    transport.onMessage = [&game](ConnectionId conn, std::string_view msg)
+    { game.handleMessage(conn, msg); };
+    transport.onDisconnected = [&game](ConnectionId conn)
+    { game.handlePlayerDisconnected(conn); };
+
+    std::mt19937 rng(7);
+    std::uniform_int_distribution<int> coord(0, 1999);
+    std::uniform_int_distribution<int> step(-10, 10);
+
+    struct SimClient
+    {
+        ConnectionId conn;
+        int x, y;
+        int64_t lastTick = -1;
+        uint64_t bytes = 0;
+        bool slow = false;
+    };
+    std::vector<SimClient> sims(clients);
+    for (int i = 0; slowEvery > 0 && i < clients; i += slowEvery)
+        sims[i].slow = true;
+    const std::string join = json ? "{\"action\":\"join\"}"
+                                  : "{\"action\":\"join\",\"encodings\":[\"bin1\"]}";
+    for (auto &c : sims)
+    {
+        c.conn = transport.connect();
+        c.x = coord(rng);
+        c.y = coord(rng);
+        transport.clientSend(c.conn, join);
+    }
+
+    std::deque<LoopbackTransport::Payload> inbox;
+    uint64_t staleSnapshots = 0;
+    size_t maxSnapshotBytes = 0;
+    const auto start = std::chrono::steady_clock::now();
+    for (int t = 0; t < ticks; ++t)
+    {
+        for (auto &c : sims)
+        {
+            if (c.slow && t % kSlowReadInterval != 0)
+            {
+                // Client chậm: không đọc, không ack, vẫn di chuyển
+                transport.clientSend(c.conn, "{\"action\":\"move\",\"x\":" + std::to_string(c.x) + ",\"y\":" + std::to_string(c.y) + "}");
+                continue;
+            }
+            inbox.clear();
+            transport.receive(c.conn, inbox);
+            for (const auto &msg : inbox)
+            {
+                c.bytes += msg->size();
+                int64_t tick = snapshotTick(*msg);
+                if (tick > c.lastTick)
+                    c.lastTick = tick;
+                if (tick >= 0)
+                    maxSnapshotBytes = std::max(maxSnapshotBytes, msg->size());
+            }
+            // Snapshot mới nhất phải là của tick vừa chạy (loopback không có trễ mạng)
+            if (t > 0 && !c.slow && c.lastTick != static_cast<int64_t>(game.world().tick()))
+                ++staleSnapshots;
+            if (c.lastTick >= 0 && !noAck)
+                transport.clientSend(c.conn, "{\"action\":\"ack\",\"tick\":" + std::to_string(c.lastTick) + "}");
+
+            c.x = std::clamp(c.x + step(rng), 0, 1999);
+            c.y = std::clamp(c.y + step(rng), 0, 1999);
+            transport.clientSend(c.conn, "{\"action\":\"move\",\"x\":" + std::to_string(c.x) + ",\"y\":" + std::to_string(c.y) + "}");
+        }
+        game.runTick();
+    }
+    const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    const LoopbackTransport::Stats stats = transport.stats();
+    const TickStats tickStats = game.tickStats();
+    std::cout << std::fixed << std::setprecision(1);
+    std::cout << "clients=" << clients << " ticks=" << ticks << " encoding=" << (json ? "json" : kBinaryEncodingName)
+              << " wall=" << seconds << "s ticks/s=" << ticks / seconds << "\n";
+    std::cout << "server->client msgs=" << stats.messagesSent << " bytes=" << stats.bytesSent
+              << " bytes/client/tick=" << static_cast<double>(stats.bytesSent) / clients / ticks
+              << " dropped=" << stats.dropped << " stale=" << staleSnapshots << "\n";
+    if (datagramSize)
+        std::cout << "datagrams=" << stats.datagrams << " fallbacks=" << stats.datagramFallbacks << "\n";
+    std::cout << "sends=" << stats.sends << " coalesced msgs=" << stats.coalescedMessages
+              << " coalesced bytes=" << stats.coalescedBytes << "\n";
+    if (slowEvery)
+    {
+        size_t maxDepth = 0;
+        for (const auto &c : sims)
+            maxDepth = std::max(maxDepth, transport.sendQueue(c.conn).queuedMessages);
+        std::cout << "slow clients: dropped snapshots=" << stats.droppedSnapshots << " max queue depth=" << maxDepth << "\n";
+    }
+    std::cout << "client->server msgs=" << stats.messagesReceived << " bytes=" << stats.bytesReceived << "\n";
+    std::cout << tickStats.summary(0) << "\n";
+
+    if (noAck)
+    {
+        const size_t budget = static_cast<size_t>(std::max(0, config.snapshotBudgetBytes));
+        const bool overBudget = maxSnapshotBytes > budget;
+        const bool ok = overBudget && tickStats.deferredUpdates == 0;
+        std::cout << "no-ack check: max snapshot=" << maxSnapshotBytes << " budget=" << budget
+                  << " deferredUpdates=" << tickStats.deferredUpdates << " -> " << (ok ? "OK" : "FAILED")
+                  << (overBudget ? "" : " (snapshot did not exceed budget)") << "\n";
+        return ok ? 0 : 1;
+    }
+    return 0;
+}
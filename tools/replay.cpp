@@ -0,0 +1,148 @@
+// Chạy lại file log (.rec) của một phòng qua đúng code tick của server, nhanh nhất
+// có thể và không cần msquic. Dùng để profile traffic thật offline và kiểm tra một
+// thay đổi tối ưu không làm lệch kết quả mô phỏng (so checksum ghi lúc chạy thật).
+//
+//   replay <file.rec> [--repeat N]
+//
+// Mã thoát khác 0 nếu file hỏng hoặc có checksum không khớp.
+#include "src/core/replayLog.h"
+#include "src/core/tickStats.h"
+#include "src/core/world.h"
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <string>
+
+namespace
+{
+    using Clock = std::chrono::steady_clock;
+
+    struct ReplayResult
+    {
+        uint64_t inputs = 0;
+        uint64_t checksums = 0;
+        uint64_t mismatches = 0;
+        uint64_t finalChecksum = 0;
+        uint32_t ticks = 0;
+        bool ok = true;
+    };
+
+    // Một lượt chạy lại toàn bộ file; thời gian từng pha ghi vào stats
+    ReplayResult runOnce(const std::string &path, TickStats &stats)
+    {
+        ReplayResult result;
+        ReplayReader reader;
+        if (!reader.open(path))
+        {
+            std::cerr << "[Replay] " << reader.error() << "\n";
+            result.ok = false;
+            return result;
+        }
+
+        GameplayConfig config;
+        config.tickRate = static_cast<int>(reader.header().tickRate);
+        // Cùng cửa sổ bù trễ với lúc ghi: độ sâu lịch sử và mức rewind tối đa phải khớp
+        config.lagCompensationMs = static_cast<int>(reader.header().lagCompensationMs);
+        World world(config, reader.header().seed);
+        world.setLogging(false);
+
+        auto step = [&]()
+        {
+            const auto tickStart = Clock::now();
+            auto phaseStart = tickStart;
+            world.step([&](TickPhase phase)
+                       {
+                auto t = Clock::now();
+                stats.phase(phase).record(std::chrono::duration_cast<std::chrono::nanoseconds>(t - phaseStart).count());
+                phaseStart = t; });
+            stats.phase(TickPhase::Total).record(std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - tickStart).count());
+            stats.ticks++;
+        };
+
+        ReplayRecord record;
+        while (reader.next(record))
+        {
+            switch (record.kind)
+            {
+            case ReplayRecordKind::Input:
+                // Lệnh của tick T được áp dụng khi thế giới đang ở tick T - 1
+                while (world.tick() + 1 < record.tick)
+                    step();
+                world.apply(record.input);
+                result.inputs++;
+                break;
+            case ReplayRecordKind::Checksum:
+                while (world.tick() < record.tick)
+                    step();
+                result.checksums++;
+                if (world.checksum() != record.checksum)
+                {
+                    if (result.mismatches == 0)
+                        std::cerr << "[Replay] First checksum mismatch at tick " << record.tick << "\n";
+                    result.mismatches++;
+                }
+                break;
+            case ReplayRecordKind::End:
+                while (world.tick() < record.tick)
+                    step();
+                break;
+            }
+        }
+
+        if (!reader.error().empty())
+        {
+            // Server bị dừng đột ngột thì bản ghi cuối có thể dở dang: vẫn báo kết quả
+            std::cerr << "[Replay] Stopped at tick " << world.tick() << ": " << reader.error() << "\n";
+        }
+
+        result.ticks = world.tick();
+        result.finalChecksum = world.checksum();
+        return result;
+    }
+}
+
+int main(int argc, char **argv)
+{
+    if (argc < 2)
+    {
+        std::cerr << "Usage: " << argv[0] << " <file.rec> [--repeat N]\n";
+        return 2;
+    }
+
+    const std::string path = argv[1];
+    int repeat = 1;
+    for (int i = 2; i < argc; ++i)
+    {
+        if (std::strcmp(argv[i], "--repeat") == 0 && i + 1 < argc)
+            repeat = std::max(1, std::atoi(argv[++i]));
+    }
+
+    TickStats stats;
+    ReplayResult result;
+    const auto start = Clock::now();
+    for (int r = 0; r < repeat; ++r)
+    {
+        ReplayResult run = runOnce(path, stats);
+        if (!run.ok)
+            return 1;
+        // Mọi lượt phải cho cùng kết quả
+        if (r > 0 && run.finalChecksum != result.finalChecksum)
+        {
+            std::cerr << "[Replay] Run " << r << " diverged from run 0\n";
+            return 1;
+        }
+        result = run;
+    }
+    const double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+
+    std::cout << std::fixed << std::setprecision(3);
+    std::cout << "ticks=" << result.ticks << " inputs=" << result.inputs << " runs=" << repeat
+              << " wall=" << seconds << "s ns/tick=" << (stats.ticks ? seconds * 1e9 / stats.ticks : 0.0) << "\n";
+    std::cout << "checksums=" << result.checksums << " mismatches=" << result.mismatches
+              << " final=" << std::hex << result.finalChecksum << std::dec << "\n";
+    std::cout << stats.summary(0) << "\n";
+
+    return result.mismatches == 0 ? 0 : 1;
+}